@@ -0,0 +1,134 @@
+#ifndef __anytime_h__
+#define __anytime_h__
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+using namespace std;
+
+/*
+ * Bookkeeping of plan_until/plan_for of rrts_c and brrts_c. The planners
+ * keep a plan_budget_c and look at past_deadline() between the phases of
+ * an iteration and between the collision checks of find_best_parent and
+ * rewire_vertices, so the last iteration stops shortly after the deadline.
+ * Outside plan_until there is no deadline.
+ */
+typedef chrono::steady_clock plan_clock_t;
+
+struct plan_stats_t
+{
+    enum stop_reason_t {stopped_deadline=0, stopped_stalled, stopped_iterations};
+
+    stop_reason_t stop_reason;
+    size_t iterations;
+    // iterations that added a vertex, and those cut short by the deadline
+    size_t added_vertices, interrupted_iterations;
+    // seconds since plan_until was called, -1 without a solution
+    double time, first_solution_time;
+    // first coordinate of the best cost, FLT_MAX/2 without a solution
+    double initial_cost, final_cost;
+
+    void print(ostream& os=cout) const
+    {
+        const char* reasons[] = {"deadline", "stalled", "iterations"};
+        os<<"stopped: "<< reasons[stop_reason] <<" iterations: "<< iterations
+            <<" added: "<< added_vertices <<" interrupted: "<< interrupted_iterations << endl;
+        os<<"time: "<< time <<" first solution: "<< first_solution_time
+            <<" cost: "<< initial_cost <<" -> "<< final_cost << endl;
+    }
+};
+
+class plan_budget_c
+{
+    public:
+        // stop once the best cost has improved by less than a fraction
+        // stall_improvement of itself during the last stall_time seconds.
+        // Only after the first solution, stall_time = 0 turns it off.
+        double stall_time;
+        double stall_improvement;
+        // at most this many iterations per call, 0 for no limit
+        size_t max_iterations;
+
+        plan_budget_c() : stall_time(0), stall_improvement(0.01),
+            max_iterations(0), has_deadline(false) {}
+
+        bool past_deadline() const
+        {
+            return has_deadline && (plan_clock_t::now() >= deadline);
+        }
+
+        void start(const plan_clock_t::time_point& deadline_in, double cost, bool has_solution)
+        {
+            has_deadline = true;
+            deadline = deadline_in;
+            t0 = plan_clock_t::now();
+            stats = plan_stats_t();
+            stats.stop_reason = plan_stats_t::stopped_deadline;
+            stats.first_solution_time = has_solution ? 0 : -1;
+            stats.initial_cost = stats.final_cost = cost;
+            stall_t0 = t0;
+            stall_cost = cost;
+        }
+
+        // res is what iteration() returned. Returns true if planning
+        // should stop.
+        bool add_iteration(int res, double cost, bool has_solution)
+        {
+            plan_clock_t::time_point now = plan_clock_t::now();
+            stats.iterations++;
+            stats.added_vertices += (res == 0);
+            stats.interrupted_iterations += (res == interrupted);
+            stats.final_cost = cost;
+            if(has_solution && (stats.first_solution_time < 0))
+            {
+                stats.first_solution_time = seconds(t0, now);
+                stall_t0 = now;
+                stall_cost = cost;
+            }
+
+            if(now >= deadline)
+                return true;
+            if(max_iterations && (stats.iterations >= max_iterations))
+            {
+                stats.stop_reason = plan_stats_t::stopped_iterations;
+                return true;
+            }
+            if((stall_time > 0) && has_solution)
+            {
+                if(stall_cost - cost > stall_improvement*cost)
+                {
+                    stall_t0 = now;
+                    stall_cost = cost;
+                }
+                else if(seconds(stall_t0, now) >= stall_time)
+                {
+                    stats.stop_reason = plan_stats_t::stopped_stalled;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        const plan_stats_t& stop()
+        {
+            has_deadline = false;
+            stats.time = seconds(t0, plan_clock_t::now());
+            return stats;
+        }
+
+        // returned by iteration() when it stops at the deadline
+        const static int interrupted = 6;
+
+    protected:
+        bool has_deadline;
+        plan_clock_t::time_point deadline, t0, stall_t0;
+        double stall_cost;
+        plan_stats_t stats;
+
+        static double seconds(const plan_clock_t::time_point& from, const plan_clock_t::time_point& to)
+        {
+            return chrono::duration<double>(to - from).count();
+        }
+};
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef __birrts_h__
+#define __birrts_h__
+
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include "rrts.h"
+#include "brrts.h"
+using namespace std;
+
+/*
+ * Bidirectional RRT*: an rrts_c tree rooted at the start and a brrts_c
+ * tree rooted at a goal state grow in turns. Every new vertex is steered
+ * to the near vertices of the other tree, in order of the cost of the
+ * bridged path, and the first feasible connection is kept as a bridge.
+ * Both trees keep rewiring, so the cost of a bridge is recomputed from
+ * the costs of its two ends whenever the best one is looked up.
+ *
+ * Configure forward.system (map, operating and goal region) before
+ * initialize(). The backward tree gets a copy of it with its goal region
+ * moved to the start, and a separate random stream.
+ *
+ * Bridges point into both trees. Vertices freed by the tree surgery of
+ * either tree (check_tree, delete_downstream) are logged, and the bridges
+ * ending at them are dropped before the next call; use birrts_c::check_tree
+ * after the map changed, it also checks the bridges. switch_root and
+ * lazy_collision_checking are not supported, the backward tree keeps
+ * growing towards the old start and bridged paths are never checked.
+ */
+template<class vertex_tt, class edge_tt, class bvertex_tt, class bedge_tt,
+    class kdtree_tt = kdtree_c<vertex_tt::system_t::N, vertex_tt*>,
+    class bkdtree_tt = kdtree_c<bvertex_tt::system_t::N, bvertex_tt*> >
+class birrts_c
+{
+    public:
+        typedef rrts_c<vertex_tt, edge_tt, kdtree_tt> rrts_t;
+        typedef brrts_c<bvertex_tt, bedge_tt, bkdtree_tt> brrts_t;
+
+        typedef typename rrts_t::system_t system_t;
+        typedef typename system_t::state state;
+        typedef typename system_t::opt_data_t opt_data_t;
+        typedef typename system_t::trajectory trajectory_t;
+        typedef typename system_t::cost_t cost_t;
+        typedef typename system_t::region_t region_t;
+
+        typedef typename rrts_t::vertex vertex;
+        typedef typename brrts_t::bvertex bvertex;
+
+        rrts_t forward;
+        brrts_t backward;
+
+        birrts_c()
+        {
+            forward.removed_vertices = &removed_vertices;
+            backward.removed_bvertices = &removed_bvertices;
+        }
+        birrts_c(plotter_c* plotter_in) : forward(plotter_in), backward(plotter_in)
+        {
+            forward.removed_vertices = &removed_vertices;
+            backward.removed_bvertices = &removed_bvertices;
+        }
+
+        // the goal state has to lie in forward.system.goal_region
+        int initialize(const state& start, const state& goal, bool do_branch_and_bound_in=true)
+        {
+            bridges.clear();
+            removed_vertices.clear();
+            removed_bvertices.clear();
+            best_bridge = -1;
+            best_bridge_cost = forward.system.get_inf_cost();
+
+            backward.system = forward.system;
+            backward.system.rng = forward.system.rng.fork();
+            backward.system.goal_region = region_t(start.x, forward.system.goal_region.s,
+                    forward.system.goal_region.color);
+
+            forward.initialize(start, do_branch_and_bound_in);
+            backward.initialize(goal, do_branch_and_bound_in);
+            return 0;
+        }
+        // roots the backward tree at the center of the goal region
+        int initialize(const state& start, bool do_branch_and_bound_in=true)
+        {
+            return initialize(start, state(forward.system.goal_region.c), do_branch_and_bound_in);
+        }
+
+        // one iteration of each tree, the new vertices are connected to the
+        // other tree. Returns 0 if either tree grew.
+        int iteration()
+        {
+            if(drop_removed_bridges())
+                update_best_bridge();
+
+            int rf = forward.iteration();
+            if(!rf && forward.last_added_vertex)
+                connect_forward(*(forward.last_added_vertex));
+
+            int rb = backward.iteration();
+            if(!rb && backward.last_added_bvertex)
+                connect_backward(*(backward.last_added_bvertex));
+
+            return (rf && rb) ? 1 : 0;
+        }
+
+        // the cheaper of the best bridged path and a forward path that
+        // reached the goal region on its own
+        cost_t get_best_cost()
+        {
+            drop_removed_bridges();
+            update_best_bridge();
+            cost_t c = forward.get_best_cost();
+            if(best_bridge >= 0)
+            {
+                if((!forward.lower_bound_vertex) || (best_bridge_cost < c))
+                    return best_bridge_cost;
+            }
+            return c;
+        }
+
+        int get_best_trajectory(trajectory_t& best_traj)
+        {
+            drop_removed_bridges();
+            update_best_bridge();
+            if(best_bridge < 0)
+                return forward.get_best_trajectory(best_traj);
+            if(forward.lower_bound_vertex && (forward.get_best_cost() < best_bridge_cost))
+                return forward.get_best_trajectory(best_traj);
+
+            bridge_t& b = bridges[best_bridge];
+            forward.get_trajectory_root(*(b.v), best_traj);
+
+            trajectory_t traj;
+            if(forward.system.extend_to(b.v->state, b.w->state, false, traj, b.opt_data))
+                return 1;
+            best_traj.append(traj);
+
+            backward.get_trajectory_root(*(b.w), traj);
+            best_traj.append(traj);
+            return 0;
+        }
+
+        size_t get_num_bridges()
+        {
+            drop_removed_bridges();
+            return bridges.size();
+        }
+
+        // check_tree of both trees, then the bridges left are collision
+        // checked again. Returns 1 if the start or the goal state collides.
+        int check_tree()
+        {
+            int rf = forward.check_tree();
+            int rb = backward.check_tree();
+            drop_removed_bridges();
+
+            size_t n = 0;
+            for(auto& b : bridges)
+            {
+                if(forward.system.is_feasible(b.v->state, b.w->state, b.opt_data))
+                    bridges[n++] = b;
+            }
+            bridges.resize(n);
+            update_best_bridge();
+            return (rf || rb) ? 1 : 0;
+        }
+
+        void plot_tree()
+        {
+            forward.plot_tree();
+            backward.plot_tree();
+        }
+
+        void plot_best_trajectory()
+        {
+            trajectory_t best_traj;
+            if(get_best_trajectory(best_traj))
+                return;
+            forward.plot_trajectory(best_traj, forward.best_lines_color, forward.best_lines_width);
+        }
+
+    protected:
+        struct bridge_t
+        {
+            vertex* v;
+            bvertex* w;
+            cost_t cost;
+            opt_data_t opt_data;
+        };
+        vector<bridge_t> bridges;
+        // filled by remove_vertices of the two trees
+        vector<vertex*> removed_vertices;
+        vector<bvertex*> removed_bvertices;
+        // index into bridges, and its cost when it was last computed. Costs
+        // only drop as the trees are rewired, so a stale cost still bounds.
+        int best_bridge;
+        cost_t best_bridge_cost;
+
+        struct candidate_t
+        {
+            vertex* v;
+            bvertex* w;
+            cost_t edge_cost;
+            cost_t total_cost;
+            opt_data_t opt_data;
+        };
+        vector<candidate_t> candidates;
+        vector<vertex*> near_vertices;
+        vector<bvertex*> near_bvertices;
+
+        static bool strictly_less(const cost_t& c1, const cost_t& c2)
+        {
+            return (c1 < c2) && !(c2 < c1);
+        }
+
+        static bool compare_candidates(const candidate_t& c1, const candidate_t& c2)
+        {
+            return strictly_less(c1.total_cost, c2.total_cost);
+        }
+
+        // drops the bridges to vertices freed since the last call, before
+        // their slots are handed out again. Returns 1 if any was dropped.
+        int drop_removed_bridges()
+        {
+            if(removed_vertices.empty() && removed_bvertices.empty())
+                return 0;
+            unordered_set<vertex*> vs(removed_vertices.begin(), removed_vertices.end());
+            unordered_set<bvertex*> ws(removed_bvertices.begin(), removed_bvertices.end());
+            removed_vertices.clear();
+            removed_bvertices.clear();
+
+            size_t n = 0;
+            for(auto& b : bridges)
+            {
+                if(!vs.count(b.v) && !ws.count(b.w))
+                    bridges[n++] = b;
+            }
+            int dropped = (n < bridges.size());
+            bridges.resize(n);
+            return dropped;
+        }
+
+        cost_t get_bridge_cost(const bridge_t& b) const
+        {
+            return b.v->cost_from_root + b.cost + b.w->cost_to_root;
+        }
+
+        int update_best_bridge()
+        {
+            best_bridge = -1;
+            best_bridge_cost = forward.system.get_inf_cost();
+            for(size_t i=0; i<bridges.size(); i++)
+            {
+                cost_t c = get_bridge_cost(bridges[i]);
+                if((best_bridge < 0) || strictly_less(c, best_bridge_cost))
+                {
+                    best_bridge = i;
+                    best_bridge_cost = c;
+                }
+            }
+            return 0;
+        }
+
+        int add_candidate(vertex& v, bvertex& w)
+        {
+            candidate_t c;
+            double dt;
+            if(forward.system.evaluate_extend_cost(v.state, w.state, c.opt_data, c.edge_cost, dt))
+                return 1;
+            c.total_cost = v.cost_from_root + c.edge_cost + w.cost_to_root;
+            if((best_bridge >= 0) && !strictly_less(c.total_cost, best_bridge_cost))
+                return 1;
+            c.v = &v;
+            c.w = &w;
+            candidates.push_back(c);
+            return 0;
+        }
+
+        // collision checks the candidates in order of cost, keeps the first
+        // feasible one
+        int connect_candidates()
+        {
+            sort(candidates.begin(), candidates.end(), compare_candidates);
+            for(auto& c : candidates)
+            {
+                if(!forward.system.is_feasible(c.v->state, c.w->state, c.opt_data))
+                    continue;
+                bridge_t b;
+                b.v = c.v;
+                b.w = c.w;
+                b.cost = c.edge_cost;
+                b.opt_data = c.opt_data;
+                bridges.push_back(b);
+                best_bridge = bridges.size()-1;
+                best_bridge_cost = c.total_cost;
+                return 0;
+            }
+            return 1;
+        }
+
+        int connect_forward(vertex& v)
+        {
+            candidates.clear();
+            near_bvertices.clear();
+            if(backward.get_near_vertices(v.state, near_bvertices))
+                return 1;
+            for(auto& pw : near_bvertices)
+                add_candidate(v, *pw);
+            return connect_candidates();
+        }
+
+        int connect_backward(bvertex& w)
+        {
+            candidates.clear();
+            near_vertices.clear();
+            if(forward.get_near_vertices(w.state, near_vertices))
+                return 1;
+            for(auto& pv : near_vertices)
+                add_candidate(*pv, w);
+            return connect_candidates();
+        }
+};
+#endif
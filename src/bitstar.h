@@ -0,0 +1,343 @@
+#ifndef __bitstar_h__
+#define __bitstar_h__
+
+#include <vector>
+#include <queue>
+#include <unordered_set>
+#include "rrts.h"
+using namespace std;
+
+/*
+ * Batch Informed Trees (BIT*, Gammell et al.) on top of rrts_c. Samples are
+ * drawn batch_size at a time and kept out of the tree until an edge
+ * connects them. Edges from the tree to near samples, and from new tree
+ * vertices to near tree vertices, are queued on g(v) + c(v,x) + h(x), where
+ * c is the steering cost of system.evaluate_extend_cost. Only the edge at
+ * the head of the queue is collision checked. A batch ends when no queued
+ * edge can improve the best cost, the samples that cannot improve it are
+ * then dropped.
+ *
+ * h is cost_to_go_heuristic(), zero unless a derived class supplies an
+ * admissible estimate. Tree surgery (switch_root, check_tree,
+ * delete_downstream), lazy_collision_checking and rrts_c::iteration() are
+ * not available on this planner.
+ */
+template<class vertex_tt, class edge_tt,
+    class kdtree_tt = kdtree_c<vertex_tt::system_t::N, vertex_tt*> >
+class bitstar_c : public rrts_c<vertex_tt, edge_tt, kdtree_tt>
+{
+    public:
+        typedef rrts_c<vertex_tt, edge_tt, kdtree_tt> rrts_t;
+
+        typedef typename rrts_t::system_t system_t;
+        typedef typename rrts_t::state state;
+        typedef typename rrts_t::opt_data_t opt_data_t;
+        typedef typename rrts_t::trajectory_t trajectory_t;
+        typedef typename rrts_t::cost_t cost_t;
+        typedef typename rrts_t::vertex vertex;
+        typedef typename rrts_t::edge edge;
+        typedef typename rrts_t::kdtree_t kdtree_t;
+
+        const static size_t num_dim = rrts_t::num_dim;
+
+        size_t batch_size;
+        int num_batches;
+
+        bitstar_c(size_t batch_size_in=100)
+        {
+            batch_size = batch_size_in;
+            num_batches = 0;
+        }
+        bitstar_c(plotter_c* plotter_in, size_t batch_size_in=100) : rrts_t(plotter_in)
+        {
+            batch_size = batch_size_in;
+            num_batches = 0;
+        }
+
+        int initialize(const state& rs, bool do_branch_and_bound_in=true)
+        {
+            samples.clear();
+            sample_kdtree.clear();
+            clear_queues();
+            old_vertices.clear();
+            num_batches = 0;
+            return rrts_t::initialize(rs, do_branch_and_bound_in);
+        }
+
+        // processes the edge at the head of the queue and returns 0 if it
+        // changed the tree. Starts a new batch and returns 2 once no queued
+        // edge can improve the best cost.
+        int iteration()
+        {
+            if(!this->root)
+                return 1;
+            this->last_added_vertex = NULL;
+
+            while(!vertex_queue.empty() && ( edge_queue.empty() ||
+                        !strictly_less(edge_queue.top().key, vertex_queue.top().key)))
+            {
+                vertex* v = vertex_queue.top().v;
+                vertex_queue.pop();
+                expand_vertex(*v);
+            }
+
+            if(edge_queue.empty() || !strictly_less(edge_queue.top().key, this->lower_bound_cost))
+            {
+                start_batch();
+                return 2;
+            }
+
+            edge_entry_t e = edge_queue.top();
+            edge_queue.pop();
+            return process_edge(e);
+        }
+
+        // runs iteration() until a new batch is started
+        int iterate_batch()
+        {
+            while(true)
+            {
+                int res = iteration();
+                if(res == 1)
+                    return 1;
+                if(res == 2)
+                    return 0;
+            }
+        }
+
+        // lower bound on the cost from the root, the steering cost without
+        // obstacles. Steering is optimal for the systems in this repository.
+        virtual cost_t cost_to_come_heuristic(const state& s)
+        {
+            opt_data_t opt_data;
+            cost_t c;
+            if(this->system.evaluate_extend_cost(this->root->state, s, opt_data, c))
+                return this->system.get_zero_cost();
+            return c;
+        }
+
+        // lower bound on the cost to the goal region
+        virtual cost_t cost_to_go_heuristic(const state& s)
+        {
+            return this->system.get_zero_cost();
+        }
+
+        size_t get_num_samples() const
+        {
+            return samples.size();
+        }
+
+    protected:
+        struct vertex_entry_t
+        {
+            cost_t key;
+            vertex* v;
+        };
+        struct edge_entry_t
+        {
+            cost_t key;
+            vertex* v;
+            vertex* x;
+            cost_t edge_cost;
+            double dt;
+            opt_data_t opt_data;
+        };
+        // cost_t::operator< is <=, the queues pop the smallest key first
+        struct compare_entries_t
+        {
+            template<class entry_t>
+            bool operator()(const entry_t& e1, const entry_t& e2) const
+            {
+                return strictly_less(e2.key, e1.key);
+            }
+        };
+
+        // samples that are not in the tree yet, indexed by sample_kdtree.
+        // Connected samples stay in the index until the next batch.
+        vector<vertex*> samples;
+        kdtree_t sample_kdtree;
+        double near_radius;
+        size_t near_k;
+
+        priority_queue<vertex_entry_t, vector<vertex_entry_t>, compare_entries_t> vertex_queue;
+        priority_queue<edge_entry_t, vector<edge_entry_t>, compare_entries_t> edge_queue;
+        // vertices expanded in this batch, and those in the tree when it started
+        unordered_set<vertex*> expanded_vertices;
+        unordered_set<vertex*> old_vertices;
+        vector<vertex*> near_buffer;
+
+        static bool strictly_less(const cost_t& c1, const cost_t& c2)
+        {
+            return (c1 < c2) && !(c2 < c1);
+        }
+
+        bool is_in_tree(const vertex& v) const
+        {
+            return v.parent || (&v == this->root);
+        }
+
+        void clear_queues()
+        {
+            vertex_queue = decltype(vertex_queue)();
+            edge_queue = decltype(edge_queue)();
+            expanded_vertices.clear();
+        }
+
+        void push_vertex(vertex& v)
+        {
+            vertex_entry_t e;
+            e.key = v.cost_from_root + cost_to_go_heuristic(v.state);
+            e.v = &v;
+            vertex_queue.push(e);
+        }
+
+        int get_near(const kdtree_t& tree, const state& s, vector<vertex*>& near)
+        {
+            double key[num_dim];
+            this->system.get_key(s, key);
+            near.clear();
+            if(this->use_k_nearest)
+                return tree.nearest_n(key, near_k, near);
+            return tree.near_range(key, near_radius, near);
+        }
+
+        // queues the edge v -> x if it can improve the best cost
+        int queue_edge(vertex& v, vertex& x)
+        {
+            edge_entry_t e;
+            if(this->system.evaluate_extend_cost(v.state, x.state, e.opt_data, e.edge_cost, e.dt))
+                return 1;
+            e.key = v.cost_from_root + e.edge_cost + cost_to_go_heuristic(x.state);
+            if(!strictly_less(e.key, this->lower_bound_cost))
+                return 1;
+            e.v = &v;
+            e.x = &x;
+            edge_queue.push(e);
+            return 0;
+        }
+
+        int expand_vertex(vertex& v)
+        {
+            if(!expanded_vertices.insert(&v).second)
+                return 1;
+
+            get_near(sample_kdtree, v.state, near_buffer);
+            for(auto& px : near_buffer)
+            {
+                if(!is_in_tree(*px))
+                    queue_edge(v, *px);
+            }
+
+            // rewiring edges, only from vertices added in this batch
+            if(old_vertices.count(&v))
+                return 0;
+            get_near(this->kdtree, v.state, near_buffer);
+            for(auto& pw : near_buffer)
+            {
+                if((pw == &v) || (pw == v.parent) || (pw->parent == &v))
+                    continue;
+                if(strictly_less(v.cost_from_root, pw->cost_from_root))
+                    queue_edge(v, *pw);
+            }
+            return 0;
+        }
+
+        // the key was computed when the edge was queued, costs in the tree
+        // may have dropped since. Both checks use the current costs.
+        int process_edge(edge_entry_t& e)
+        {
+            vertex& v = *(e.v);
+            vertex& x = *(e.x);
+            cost_t cx = v.cost_from_root + e.edge_cost;
+            if(!strictly_less(cx + cost_to_go_heuristic(x.state), this->lower_bound_cost))
+                return 3;
+            bool in_tree = is_in_tree(x);
+            if(in_tree && !strictly_less(cx, x.cost_from_root))
+                return 3;
+
+            if(!this->system.is_feasible(v.state, x.state, e.opt_data))
+                return 4;
+
+            edge* en = this->edge_pool.construct(&(v.state), &(x.state), e.edge_cost, e.dt, e.opt_data);
+            en->is_checked = true;
+            if(in_tree)
+            {
+                this->insert_edge(v, *en, x);
+                this->update_branch_cost(x);
+            }
+            else
+            {
+                this->insert_into_kdtree(x);
+                this->insert_edge(v, *en, x);
+                push_vertex(x);
+            }
+            this->last_added_vertex = &x;
+            return 0;
+        }
+
+        bool can_improve(const state& s)
+        {
+            if(!this->lower_bound_vertex)
+                return true;
+            return strictly_less(cost_to_come_heuristic(s) + cost_to_go_heuristic(s),
+                    this->lower_bound_cost);
+        }
+
+        int start_batch()
+        {
+            num_batches++;
+            clear_queues();
+
+            // 1. drop connected samples and those that cannot improve the best cost
+            size_t n = 0;
+            for(auto& px : samples)
+            {
+                if(is_in_tree(*px))
+                    continue;
+                if(can_improve(px->state))
+                    samples[n++] = px;
+                else
+                    this->vertex_pool.destroy(px);
+            }
+            samples.resize(n);
+
+            // 2. new samples
+            for(size_t i=0; i<batch_size; i++)
+            {
+                state s;
+                int ret = 0;
+                if(this->system.rng.uniform() < this->goal_sample_freq)
+                    ret = this->system.sample_in_goal(s);
+                else
+                    ret = this->system.sample_state(s);
+                if(ret || !can_improve(s))
+                    continue;
+                samples.push_back(this->vertex_pool.construct(s));
+            }
+
+            sample_kdtree.clear();
+            sample_kdtree.reserve(samples.size());
+            double key[num_dim];
+            for(auto& px : samples)
+            {
+                this->system.get_key(px->state, key);
+                sample_kdtree.insert(key, px);
+            }
+
+            // 3. connection radius over the tree and the samples
+            double q = this->num_vertices + samples.size();
+            near_radius = this->gamma*pow(this->system.get_informed_volume_fraction()*log(q + 1.0)/(q + 1.0),
+                    1.0/(double)num_dim);
+            near_k = ceil(this->k_rrt*log(q + 1.0));
+
+            // 4. every tree vertex is expanded again
+            old_vertices.clear();
+            for(auto& pv : this->list_vertices)
+            {
+                old_vertices.insert(pv);
+                push_vertex(*pv);
+            }
+            return 0;
+        }
+};
+#endif
@@ -0,0 +1,125 @@
+#ifndef __box_map_h__
+#define __box_map_h__
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include "map.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+using namespace std;
+
+/*
+ * Map of axis-aligned box obstacles over the first M coordinates of the
+ * state, e.g. M=2 boxes in the plane for dubins_c. Box bounds are kept per
+ * dimension in flat arrays. Built with -mavx2 (SMPL_USE_AVX2 in cmake) the
+ * batch check tests four states against a box at once.
+ */
+template<size_t N, size_t M=2>
+class box_map_c : public map_c<N>
+{
+    public:
+        vector<double> lo[M];
+        vector<double> hi[M];
+
+        box_map_c() {}
+
+        int add_box(const double* center, const double* size)
+        {
+            for(size_t d=0; d<M; d++)
+            {
+                lo[d].push_back(center[d] - size[d]/2.0);
+                hi[d].push_back(center[d] + size[d]/2.0);
+            }
+            return 0;
+        }
+        void clear()
+        {
+            for(size_t d=0; d<M; d++)
+            {
+                lo[d].clear();
+                hi[d].clear();
+            }
+        }
+        size_t num_boxes() const
+        {
+            return lo[0].size();
+        }
+
+        bool is_in_collision(const double s[N])
+        {
+            size_t nb = num_boxes();
+            for(size_t b=0; b<nb; b++)
+            {
+                bool inside = true;
+                for(size_t d=0; d<M; d++)
+                    inside = inside && (s[d] >= lo[d][b]) && (s[d] <= hi[d][b]);
+                if(inside)
+                    return true;
+            }
+            return false;
+        }
+
+        // distance to the closest box over the first M coordinates
+        double get_clearance(const double s[N])
+        {
+            double best = DBL_MAX;
+            size_t nb = num_boxes();
+            for(size_t b=0; b<nb; b++)
+            {
+                double t = 0;
+                for(size_t d=0; d<M; d++)
+                {
+                    double e = max(max(lo[d][b] - s[d], s[d] - hi[d][b]), 0.0);
+                    t += e*e;
+                }
+                best = min(best, t);
+            }
+            return sqrt(best);
+        }
+
+        int is_in_collision_batch(const double* states, size_t count, uint8_t* out)
+        {
+            size_t i = 0;
+#ifdef __AVX2__
+            size_t nb = num_boxes();
+            for(; i+4 <= count; i+=4)
+            {
+                __m256d x[M];
+                for(size_t d=0; d<M; d++)
+                    x[d] = _mm256_loadu_pd(states + d*count + i);
+
+                __m256d hit = _mm256_setzero_pd();
+                for(size_t b=0; b<nb; b++)
+                {
+                    __m256d inside = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+                    for(size_t d=0; d<M; d++)
+                    {
+                        inside = _mm256_and_pd(inside,
+                                _mm256_cmp_pd(x[d], _mm256_set1_pd(lo[d][b]), _CMP_GE_OQ));
+                        inside = _mm256_and_pd(inside,
+                                _mm256_cmp_pd(x[d], _mm256_set1_pd(hi[d][b]), _CMP_LE_OQ));
+                    }
+                    hit = _mm256_or_pd(hit, inside);
+                    if(_mm256_movemask_pd(hit) == 0xf)
+                        break;
+                }
+                int mask = _mm256_movemask_pd(hit);
+                for(int j=0; j<4; j++)
+                    out[i+j] = (mask >> j) & 1;
+            }
+#endif
+            double s[N] = {0};
+            for(; i<count; i++)
+            {
+                for(size_t d=0; d<M; d++)
+                    s[d] = states[d*count + i];
+                out[i] = is_in_collision(s);
+            }
+            return 0;
+        }
+};
+
+#endif
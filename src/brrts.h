@@ -6,7 +6,8 @@
 #include <vector>
 #include <set>
 #include <cfloat>
-#include "kdtree.h"
+#include "kd_tree.h"
+#include "pool.h"
 #include <algorithm>
 #include <tuple>
 #include <functional>
@@ -15,10 +16,8 @@
 #include "system.h"
 #include "utils.h"
 
-#include <lcm/lcm.h>
-#include <bot_core/bot_core.h>
-#include <bot_lcmgl_client/lcmgl.h>
-#include <bot_vis/gl_util.h>
+#include "plotter.h"
+#include "anytime.h"
 
 using namespace std;
 
@@ -57,11 +56,6 @@ class bvertex_c
             mark = 0;
             t0 =0;
         }
-        ~bvertex_c()
-        {
-            if(bedge_to_child)
-                delete bedge_to_child;
-        }
         bvertex_c(const state_t& si)
         {
             child = NULL;
@@ -105,12 +99,16 @@ class bedge_c
         cost_t cost;
         opt_data_t opt_data;
         double dt;
+        // steered trajectory, kept by brrts_c::get_bedge_trajectory() and
+        // freed with the bedge
+        trajectory* traj;
 
         bedge_c()
         {
             end_state = NULL;
             start_state = NULL;
             dt = 0;
+            traj = NULL;
         };
 
         bedge_c(const state* si, const state* se, cost_t& c, double dt_in, opt_data_t& opt_data_in)
@@ -120,10 +118,20 @@ class bedge_c
             opt_data = opt_data_in;
             cost = c;
             dt = dt_in;
+            traj = NULL;
+        }
+        ~bedge_c()
+        {
+            delete traj;
         }
+
+    private:
+        bedge_c(const bedge_c&);
+        bedge_c& operator=(const bedge_c&);
 };
 
-template<class bvertex_tt, class bedge_tt>
+template<class bvertex_tt, class bedge_tt,
+    class kdtree_tt = kdtree_c<bvertex_tt::system_t::N, bvertex_tt*> >
 class brrts_c
 {
     public:
@@ -141,8 +149,7 @@ class brrts_c
         typedef bvertex_tt bvertex;
         typedef bedge_tt bedge;
 
-        typedef struct kdtree kdtree_t;
-        typedef struct kdres kdres_t;
+        typedef kdtree_tt kdtree_t;
 
         system_t system;
 
@@ -152,14 +159,32 @@ class brrts_c
         double goal_sample_freq;
         bool do_branch_and_bound;
 
+        // k-nearest RRT*: connect to the k = k_rrt*log(n) nearest vertices
+        // instead of those within gamma*(log(n)/n)^(1/d)
+        bool use_k_nearest;
+        double k_rrt;
+
+        // keep the trajectories of the bedges on the paths extracted by
+        // get_trajectory_root, plot_tree only reads them
+        bool cache_trajectories;
+
         bvertex* root;
         cost_t lower_bound_cost;
         bvertex* lower_bound_bvertex;
-        kdtree_t* kdtree;
+        kdtree_t kdtree;
+        pool_c<bvertex> bvertex_pool;
+        pool_c<bedge> bedge_pool;
+        vector<bvertex*> near_vertices_buffer;
         bvertex* last_added_bvertex;
+        // if set, remove_vertices appends every bvertex it frees
+        vector<bvertex*>* removed_bvertices;
+
+        // deadline and early stop of plan_until
+        plan_budget_c budget;
 
         static int debug_counter;
-        bot_lcmgl_t* lcmgl;
+        // draws the snapshots of the plot_* calls, may be NULL
+        plotter_c* plotter;
         double points_color[4];
         double points_size;
         double lines_color[4];
@@ -168,6 +193,7 @@ class brrts_c
         double best_lines_width;
 
         brrts_c(){
+            plotter = NULL;
             basic_initialization();
         }
 
@@ -197,12 +223,15 @@ class brrts_c
             gamma = 2.5;
             goal_sample_freq = 0.1;
             do_branch_and_bound = true;
+            use_k_nearest = false;
+            cache_trajectories = true;
+            k_rrt = 1.1*(M_E + M_E/(double)num_dim);
 
             root = NULL;
             lower_bound_bvertex = NULL;
             last_added_bvertex = NULL;
+            removed_bvertices = NULL;
 
-            kdtree = NULL;
             num_vertices = 0;
 
             double pc[4] = {1,1,0,0.9};
@@ -213,29 +242,60 @@ class brrts_c
             set_best_lines_color(blc, 4);
         }
 
-        brrts_c(bot_lcmgl_t* lcmgl_in){
-            lcmgl = lcmgl_in;
+        brrts_c(plotter_c* plotter_in){
+            plotter = plotter_in;
             basic_initialization();
         }
 
         ~brrts_c()
         {
-            if(kdtree)
-                kd_free(kdtree);
             clear_list_vertices();
         }
 
+        // runs iterations until the deadline and cuts the last one short,
+        // or stops earlier as set in budget (anytime.h). Afterwards
+        // best_traj is the best trajectory, returns 1 if there is none.
+        int plan_until(const plan_clock_t::time_point& deadline, trajectory_t& best_traj,
+                plan_stats_t* plan_stats=NULL)
+        {
+            budget.start(deadline, lower_bound_cost.val[0], lower_bound_bvertex != NULL);
+            bool done = (plan_clock_t::now() >= deadline);
+            while(!done)
+            {
+                int res = iteration();
+                done = budget.add_iteration(res, lower_bound_cost.val[0], lower_bound_bvertex != NULL);
+            }
+            const plan_stats_t& s = budget.stop();
+            if(plan_stats)
+                *plan_stats = s;
+            return get_best_trajectory(best_traj);
+        }
+        template<class rep_t, class period_t>
+        int plan_for(const chrono::duration<rep_t, period_t>& duration, trajectory_t& best_traj,
+                plan_stats_t* plan_stats=NULL)
+        {
+            return plan_until(plan_clock_t::now() + chrono::duration_cast<plan_clock_t::duration>(duration),
+                    best_traj, plan_stats);
+        }
+
         void clear_list_vertices()
         {
-            for(auto& i : list_vertices)
-                delete i;
+            bvertex_pool.clear();
+            bedge_pool.clear();
             list_vertices.clear();
             num_vertices = 0;
         }
 
+        void free_bvertex(bvertex* v)
+        {
+            if(v->bedge_to_child)
+                bedge_pool.destroy(v->bedge_to_child);
+            bvertex_pool.destroy(v);
+        }
+
         int set_root(const state& rs)
         {
-            root = new bvertex(rs);
+            root = bvertex_pool.construct(rs);
             root->cost_to_root = system.get_zero_cost();
             root->cost_to_child = system.get_zero_cost();
             root->bedge_to_child = NULL;
@@ -254,12 +314,10 @@ class brrts_c
             lower_bound_bvertex = NULL;
             do_branch_and_bound = do_branch_and_bound_in;
 
-            if(kdtree)
-                kd_free(kdtree);
-            kdtree = kd_create(num_dim);
+            kdtree.clear();
 
             set_root(rs);
-            root->state.print(cout,"set root to:", "\n");
+            print_state(root->state, cout, "set root to:", "\n");
             last_added_bvertex = root;
 
             return 0;
@@ -296,7 +354,7 @@ class brrts_c
             if(!s_in)
             {
                 int ret = 0;
-                double p = RANDF;
+                double p = system.rng.uniform();
                 if(p < goal_sample_freq)
                     ret = system.sample_in_goal(sr);
                 else
@@ -308,15 +366,23 @@ class brrts_c
                 sr = *s_in;
 
             // 2. compute nearest vertices
-            vector<bvertex*> near_vertices;
+            vector<bvertex*>& near_vertices = near_vertices_buffer;
+            near_vertices.clear();
             if(get_near_vertices(sr, near_vertices))
                 return 2;
+            if(budget.past_deadline())
+                return plan_budget_c::interrupted;
 
             // 3. best child
             bvertex* best_child = NULL;
             bedge* bedge_to_child = NULL;
             if(find_best_child(sr, near_vertices, best_child, bedge_to_child))
-                return 3;
+                return budget.past_deadline() ? plan_budget_c::interrupted : 3;
+            if(budget.past_deadline())
+            {
+                bedge_pool.destroy(bedge_to_child);
+                return plan_budget_c::interrupted;
+            }
 
             // 4.a check if the trajectory new sample collides with collision_trajectory
             if(obstacle_trajectory)
@@ -327,13 +393,19 @@ class brrts_c
                 tmp_traj.t0 = best_child->t0; 
 
                 if(check_collision_trajectory(*obstacle_trajectory, tmp_traj, collision_distance))
+                {
+                    bedge_pool.destroy(bedge_to_child);
                     return 4;
+                }
             }
 
             // 4. draw bedge to child from new bvertex
             bvertex* new_bvertex = insert_bedge(*best_child, *bedge_to_child);
             if(!new_bvertex)
+            {
+                bedge_pool.destroy(bedge_to_child);
                 return 5;
+            }
 
             // 5. rewire
             if(near_vertices.size())
@@ -345,10 +417,9 @@ class brrts_c
 
         int insert_into_kdtree(bvertex& v)
         {
-            double* key = new double[num_dim];
+            double key[num_dim];
             system.get_key(v.state, key);
-            kd_insert(kdtree, key, &v);
-            delete[] key;
+            kdtree.insert(key, &v);
 
             list_vertices.push_back(&v);
             num_vertices++;
@@ -359,20 +430,48 @@ class brrts_c
         cost_t get_best_cost()    {return lower_bound_cost;};
         bvertex& get_best_bvertex() {return *lower_bound_bvertex;}
 
+        // the trajectory from v to its child, steered on the first call
+        // and kept on the bedge if store is set. Points to buffer otherwise.
+        int get_bedge_trajectory(bvertex& v, const trajectory_t*& traj,
+                trajectory_t& buffer, bool store)
+        {
+            bedge& e = *(v.bedge_to_child);
+            if(e.traj)
+            {
+                traj = e.traj;
+                return 0;
+            }
+            bool check_obstacles = false;
+            if(!store)
+            {
+                traj = &buffer;
+                return system.extend_to(v.state, v.child->state, check_obstacles,
+                        buffer, e.opt_data);
+            }
+            trajectory_t* t = new trajectory_t();
+            if(system.extend_to(v.state, v.child->state, check_obstacles, *t, e.opt_data))
+            {
+                delete t;
+                return 1;
+            }
+            e.traj = t;
+            traj = t;
+            return 0;
+        }
+
         int get_trajectory_root(bvertex& v, trajectory_t& root_traj)
         {
             root_traj.clear();
-            bool check_obstacles = false;
+            trajectory_t buffer;
             bvertex* vc = static_cast<bvertex*>(&v);
             while(vc)
             {
                 bvertex* vchild = static_cast<bvertex*>(vc->child);
                 if(vchild)
                 {
-                    trajectory_t traj_to_child;
-                    system.extend_to(vc->state, vchild->state, check_obstacles,
-                            traj_to_child, vc->bedge_to_child->opt_data);
-                    root_traj.append(traj_to_child);
+                    const trajectory_t* traj_to_child;
+                    if(!get_bedge_trajectory(*vc, traj_to_child, buffer, cache_trajectories))
+                        root_traj.append(*traj_to_child);
                 }
                 vc = vchild;
             }
@@ -391,59 +490,34 @@ class brrts_c
 
         int get_nearest_vertex(const state& s, bvertex*& nearest_vertex)
         {
-            int toret = 0;
-            double* key = new double[num_dim];
+            double key[num_dim];
             system.get_key(s, key);
-
-            double rn = gamma*pow(log(num_vertices + 1.0)/(num_vertices+1.0), 1.0/(double)num_dim);
-            kdres_t* kdres = kd_nearest(kdtree, key);
-            if(!kd_res_size(kdres))
-                toret = 1;
-            else
-                nearest_vertex = (bvertex*) kd_res_item_data(kdres);
-
-            delete[] key;
-            kd_res_free(kdres);
-            return toret;
+            return kdtree.nearest(key, nearest_vertex);
         }
 
         int get_near_vertices(const state& s, vector<bvertex*>& near_vertices)
         {
-            int toret = 0;
-            double* key = new double[num_dim];
+            double key[num_dim];
             system.get_key(s, key);
 
-            double rn = gamma*pow(log(num_vertices + 1.0)/(num_vertices+1.0), 1.0/(double)num_dim);
-            kdres_t* kdres = kd_nearest_range(kdtree, key, rn);
-
-            int num_near_vertices = kd_res_size(kdres);
-            if(!num_near_vertices)
+            if(use_k_nearest)
             {
-                kd_res_free(kdres);
-
-                // get nearest bvertex
-                kdres = kd_nearest(kdtree, key);
-                if(kd_res_end(kdres))
-                    toret = 1;
-                else
-                {
-                    bvertex* vc = (bvertex*) kd_res_item_data(kdres);
-                    near_vertices.push_back(vc);
-                }
+                size_t k = ceil(k_rrt*log(num_vertices + 1.0));
+                if(!kdtree.nearest_n(key, k, near_vertices))
+                    return 1;
+                return 0;
             }
-            else
+
+            double rn = gamma*pow(log(num_vertices + 1.0)/(num_vertices+1.0), 1.0/(double)num_dim);
+            if(!kdtree.near_range(key, rn, near_vertices))
             {
-                while(! kd_res_end(kdres))
-                {
-                    bvertex* vc = (bvertex*)kd_res_item_data(kdres);
-                    near_vertices.push_back(vc);
-                    kd_res_next(kdres);
-                }
+                // get nearest bvertex
+                bvertex* vc = NULL;
+                if(kdtree.nearest(key, vc))
+                    return 1;
+                near_vertices.push_back(vc);
             }
-
-            delete[] key;
-            kd_res_free(kdres);
-            return toret;
+            return 0;
         }
 
         int update_best_bvertex(bvertex& v)
@@ -471,7 +545,7 @@ class brrts_c
             }
 
             // create new bvertex
-            bvertex* new_bvertex = new bvertex(*(e.start_state));
+            bvertex* new_bvertex = bvertex_pool.construct(*(e.start_state));
             insert_into_kdtree(*new_bvertex);
 
             insert_bedge(*new_bvertex, e, ve);
@@ -487,7 +561,7 @@ class brrts_c
             update_best_bvertex(vp);
 
             if(vp.bedge_to_child)
-                delete vp.bedge_to_child;
+                bedge_pool.destroy(vp.bedge_to_child);
             vp.bedge_to_child = &e;
 
             if(vp.child)
@@ -508,37 +582,38 @@ class brrts_c
         {
             // 1. create bvertex_cost_pairs
             vector<pair<bvertex*, cost_t> > bvertex_cost_pairs;
-            unordered_map<bvertex*, tuple<cost_t, cost_t, opt_data_t> > bvertex_map;
+            unordered_map<bvertex*, tuple<cost_t, cost_t, opt_data_t, double> > bvertex_map;
             for(auto& pv : near_vertices)
             {
                 bvertex& v = *pv;
                 opt_data_t opt_data;
                 cost_t bedge_cost;
+                double edge_duration;
 
-                if(system.evaluate_extend_cost(si, v.state, opt_data, bedge_cost))
+                if(system.evaluate_extend_cost(si, v.state, opt_data, bedge_cost, edge_duration))
                     continue;
                 cost_t v_cost = v.cost_to_root + bedge_cost;
 
                 bvertex_cost_pairs.push_back(make_pair(pv, v_cost));
-                bvertex_map.insert(make_pair(pv, make_tuple(bedge_cost, v_cost, opt_data)));
+                bvertex_map.insert(make_pair(pv, make_tuple(bedge_cost, v_cost, opt_data, edge_duration)));
             }
 
             // 2. sort using compare function of cost_t
             sort(bvertex_cost_pairs.begin(), bvertex_cost_pairs.end(), compare_bvertex_cost_pairs);
 
             // 3. check obstacles in order of increasing cost
-            bool check_obstacles = true;
-            trajectory_t traj;
             for(auto& p : bvertex_cost_pairs)
             {
                 bvertex& v = *(p.first);
                 opt_data_t& opt_data = get<2>(bvertex_map[p.first]);
                 cost_t& bedge_cost = get<0>(bvertex_map[p.first]);
-                if(!system.extend_to(si, v.state, check_obstacles,traj, opt_data))
+                double edge_duration = get<3>(bvertex_map[p.first]);
+                if(budget.past_deadline())
+                    return 1;
+                if(system.is_feasible(si, v.state, opt_data))
                 {
-                    double edge_duration = system.dynamical_system.evaluate_extend_cost(si, v.state, opt_data);
                     best_child = &v;
-                    best_bedge = new bedge(&si, &(v.state), bedge_cost, edge_duration, opt_data);
+                    best_bedge = bedge_pool.construct(&si, &(v.state), bedge_cost, edge_duration, opt_data);
                     //cout<<"best_bedge.cost: "<< best_bedge.cost.val << endl;
                     return 0;
                 }
@@ -568,14 +643,15 @@ class brrts_c
 
         int rewire_vertices(bvertex& v, const vector<bvertex*>& near_vertices, set<bvertex*>* rewired_vertices)
         {
-            bool check_obstacles = true;
             for(auto& pvn : near_vertices)
             {
+                if(budget.past_deadline())
+                    break;
                 bvertex& vn = *pvn;
                 opt_data_t opt_data;
-                trajectory_t traj;
                 cost_t cost_bedge;
-                if(system.evaluate_extend_cost(vn.state, v.state, opt_data, cost_bedge))
+                double en_dt;
+                if(system.evaluate_extend_cost(vn.state, v.state, opt_data, cost_bedge, en_dt))
                     continue;
 
                 if(rewired_vertices)
@@ -583,11 +659,10 @@ class brrts_c
                 cost_t cvn = v.cost_to_root + cost_bedge;
                 if(cvn < vn.cost_to_root)
                 {
-                    if(system.extend_to(vn.state, v.state, check_obstacles, traj, opt_data))
+                    if(!system.is_feasible(vn.state, v.state, opt_data))
                         continue;
 
-                    double en_dt = system.dynamical_system.evaluate_extend_cost(vn.state, v.state, opt_data);
-                    bedge* en = new bedge(&(vn.state), &(v.state), cost_bedge, en_dt, opt_data);
+                    bedge* en = bedge_pool.construct(&(vn.state), &(v.state), cost_bedge, en_dt, opt_data);
                     insert_bedge(vn, *en, v);
 
                     update_branch_cost(vn, 0);
@@ -626,7 +701,46 @@ class brrts_c
                     surviving_vertices.push_back(pv);
                 }
                 else
-                    delete pv;
+                    free_bvertex(pv);
+            }
+            return 0;
+        }
+
+        // frees the vertices with mark != keep_mark and takes them out of
+        // list_vertices and the kd-tree, see rrts_c::remove_vertices
+        int remove_vertices(int keep_mark)
+        {
+            bool rebuild = false;
+            double key[num_dim];
+            for(auto it = list_vertices.begin(); it != list_vertices.end(); )
+            {
+                bvertex* pv = *it;
+                if(pv->mark == keep_mark)
+                {
+                    it++;
+                    continue;
+                }
+                if(!rebuild)
+                {
+                    system.get_key(pv->state, key);
+                    rebuild = kdtree.erase(key, pv);
+                }
+                if(pv == last_added_bvertex)
+                    last_added_bvertex = NULL;
+                if(removed_bvertices)
+                    removed_bvertices->push_back(pv);
+                free_bvertex(pv);
+                it = list_vertices.erase(it);
+                num_vertices--;
+            }
+            if(rebuild)
+            {
+                kdtree.clear();
+                for(auto& pv : list_vertices)
+                {
+                    system.get_key(pv->state, key);
+                    kdtree.insert(key, pv);
+                }
             }
             return 0;
         }
@@ -642,11 +756,7 @@ class brrts_c
 
         int check_and_mark_parents(bvertex& v)
         {
-            trajectory_t traj;
-            bool check_obstacles = true;
-
-            if(system.extend_to(v.child->state, v.state, check_obstacles,
-                        traj, v.bedge_to_child->opt_data))
+            if(!system.is_feasible(v.child->state, v.state, v.bedge_to_child->opt_data))
             { 
                 mark_bvertex_and_remove_from_child(v);
             }
@@ -671,25 +781,7 @@ class brrts_c
 
                 for(auto& prc : root->parents)
                     check_and_mark_parents(*prc);
-
-                list<bvertex*> surviving_vertices;
-                for(auto& pv : list_vertices)
-                {
-                    if(!pv->mark)
-                        surviving_vertices.push_back(pv);
-                    else
-                        delete pv;
-                }
-
-                if(kdtree)
-                    kd_free(kdtree);
-                kdtree = kd_create(num_dim);
-
-                list_vertices.clear();
-                num_vertices = 0;
-                for(auto& pv : surviving_vertices)
-                    insert_into_kdtree(*pv); 
-
+                remove_vertices(0);
                 update_all_costs();
             }
             return 0;
@@ -726,81 +818,81 @@ class brrts_c
             return 0;
         }
 
-        virtual void plot_trajectory(trajectory_t& traj, double* lc, double width)
+        void set_plotter(plotter_c* plotter_in)
         {
-            bot_lcmgl_color4f(lcmgl, lc[0], lc[1], lc[2], lc[3]);
-            bot_lcmgl_line_width(lcmgl, width);
-            bot_lcmgl_begin(lcmgl, GL_LINES);
-            for(auto pts = traj.states.begin(); pts != traj.states.end(); pts++)
-            {
-                double s2[3] = {0};
-                system.get_plotter_state(*pts, s2);
-                bot_lcmgl_vertex3d(lcmgl, s2[0], s2[1], s2[2]);
-
-                auto npts = pts;
-                npts++;
-                if(npts != traj.states.end()){
-                    system.get_plotter_state(*npts, s2);
-                    bot_lcmgl_vertex3d(lcmgl, s2[0], s2[1], s2[2]);
-                }
-            }
-            bot_lcmgl_end(lcmgl);
+            plotter = plotter_in;
         }
 
-        virtual void plot_tree()
+        // the vertices and edges of the tree in plotter coordinates, works
+        // without a plotter
+        int get_tree_snapshot(plot_snapshot_c& snapshot)
         {
-            bool check_obstacles = false;
             if(num_vertices == 0)
-                return;
+                return 0;
+            plot_points_t& points = snapshot.add_points(points_color, points_size);
+            plot_lines_t& lines = snapshot.add_lines(lines_color, lines_width);
+            trajectory_t buffer;
             for(auto& v : list_vertices)
             {
                 double s1[3] = {0};
                 system.get_plotter_state(v->state, s1);
-                bot_lcmgl_color4f(lcmgl, points_color[0], points_color[1], points_color[2], points_color[3]);
-                bot_lcmgl_point_size(lcmgl, points_size);
-                bot_lcmgl_begin(lcmgl, GL_POINTS);
-                bot_lcmgl_vertex3d(lcmgl, s1[0], s1[1], s1[2]);
-                bot_lcmgl_end(lcmgl);
+                points.xyz.insert(points.xyz.end(), s1, s1+3);
 
                 if(v->child){
-                    trajectory_t traj_to_child;
-                    if(system.extend_to(v->state, v->child->state, check_obstacles,
-                                traj_to_child, v->bedge_to_child->opt_data)){
+                    const trajectory_t* traj_to_child;
+                    if(get_bedge_trajectory(*v, traj_to_child, buffer, false)){
                         cout<<"extend_to returns 1 while plotting"<<endl;
-                        return;
+                        return 1;
                     }
-                    plot_trajectory(traj_to_child, lines_color, lines_width);
+                    plot_snapshot_c::add_trajectory(system, *traj_to_child, lines);
                 }
             }
+            return 0;
+        }
+
+        virtual void plot_trajectory(const trajectory_t& traj, double* lc, double width)
+        {
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            plot_snapshot_c::add_trajectory(system, traj, snapshot.add_lines(lc, width));
+            plotter->draw(snapshot);
+        }
+
+        virtual void plot_tree()
+        {
+            if(!plotter || (num_vertices == 0))
+                return;
+            plot_snapshot_c snapshot;
+            get_tree_snapshot(snapshot);
+            plotter->draw(snapshot);
         }
 
         virtual void plot_best_trajectory()
         {
             trajectory_t best_trajectory;
-            if(get_best_trajectory(best_trajectory))
+            if(!plotter || get_best_trajectory(best_trajectory))
                 return;
             plot_trajectory(best_trajectory, best_lines_color, best_lines_width); 
         }
 
         void plot_region(region_t& r)
         {
-            double c[3] = {0};
-            double s[3] = {0};
-            float sf[3] = {0};
-            r.get_plotter_state(c, s);
-            bot_lcmgl_color4f(lcmgl, r.color[0], r.color[1], r.color[2], r.color[3]);
-            double cd[3] = {0};
-            for(int i=0; i<3; i++)
-                sf[i] = s[i];
-            bot_lcmgl_box(lcmgl, c, sf);
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            snapshot.add_region(r);
+            plotter->draw(snapshot);
         }
 
         virtual void plot_environment()
         {
-            bot_lcmgl_enable(lcmgl, GL_BLEND);
-
-            plot_region(system.operating_region);
-            plot_region(system.goal_region);
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            snapshot.add_region(system.operating_region);
+            snapshot.add_region(system.goal_region);
+            plotter->draw(snapshot);
         }
 };
 #endif
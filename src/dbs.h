@@ -23,7 +23,6 @@
 
 #include <math.h>
 #include <assert.h>
-#include <glib.h>
 
 #define DEBUG       (1)
 
@@ -199,7 +198,7 @@ int dubins_LSL(double alpha, double beta, double d, double* outputs)
     if(fabs(cb-ca) < DUBINS_EPS)
         tmp1 = 0;
     double t = dbsmod2pi(-alpha + tmp1);
-    double p = sqrt(MAX(p_squared, 0));
+    double p = sqrt(fmax(p_squared, 0));
     double q = dbsmod2pi(beta - tmp1);
     PACK_OUTPUTS(outputs);
 
@@ -225,7 +224,7 @@ int dubins_RSR( double alpha, double beta, double d, double* outputs )
     if(fabs(cb-ca) < DUBINS_EPS)
         tmp1 = 0;
     double t = dbsmod2pi( alpha - tmp1);
-    double p = sqrt(MAX(p_squared, 0));
+    double p = sqrt(fmax(p_squared, 0));
     double q = dbsmod2pi( -beta + tmp1);
     PACK_OUTPUTS(outputs);
 
@@ -246,7 +245,7 @@ int dubins_LSR( double alpha, double beta, double d, double* outputs )
     {
         return EDUBNOPATH;
     }
-    double p    = sqrt(MAX(p_squared, 0));
+    double p    = sqrt(fmax(p_squared, 0));
     double tmp2 = atan2((-ca-cb), (d+sa+sb)) - atan2(-2.0, p);
     if(fabs(-ca-cb) < DUBINS_EPS)
         tmp2 = -atan2(-2., p);
@@ -270,7 +269,7 @@ int dubins_RSL( double alpha, double beta, double d, double* outputs )
     {
         return EDUBNOPATH;
     }
-    double p    = sqrt(MAX(p_squared, 0));
+    double p    = sqrt(fmax(p_squared, 0));
     double tmp2 = atan2((ca+cb), (d-sa-sb)) - atan2(2.0, p);
     if(fabs(ca + cb) < DUBINS_EPS)
         tmp2 = 0 - atan2(2.0, p);
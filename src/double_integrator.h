@@ -36,67 +36,91 @@ class double_integrator_c : public dynamical_system_c<state_c<4>, control_c<2>,
             return 0;
         }
 
-        int sample_state(double* center, double* size, double* s)
+        int sample_state(double* center, double* size, double* s, random_c& rng)
         {
+            rng.uniform(s, 4);
             for(int i : range(0,4))
-                s[i] = center[i] + (RANDF-0.5)*size[i];
+                s[i] = center[i] + (s[i]-0.5)*size[i];
             return 0;
         }
         
-        int extend_to(const state_t& si, const state_t& sf,
-                trajectory_t& traj, double_integrator_opt_data_t& opt_data)
+        // bang-bang controls and switching times of both axes, stored in
+        // opt_data
+        int get_controls(const state_t& si, const state_t& sf, double_integrator_opt_data_t& opt_data)
         {
-            if(evaluate_extend_cost(si, sf, opt_data) < 0)
-                return 1;
-
-            traj.clear();
-            traj.total_variation = opt_data.T;
+            if(opt_data.is_initialized)
+                return 0;
 
             double si1[2] = {si[0], si[2]};
             double sf1[2] = {sf[0], sf[2]};
             double si2[2] = {si[1], si[3]};
             double sf2[2] = {sf[1], sf[3]};
 
-            double T = opt_data.T, T1 = opt_data.T1, T2 = opt_data.T2;
+            double T = opt_data.T, T1 = opt_data.T1;
             double ts1, ts2;
             double um = umm;
             double u1, u2;
 
-            if(!opt_data.is_initialized)
+            double g = 1.0;
+            // dim 2 needs to slow down
+            if( fabs(T-T1) < 1e-6)
             {
-                double g = 1.0;
-                // dim 2 needs to slow down
-                if( fabs(T-T1) < 1e-6)
-                {
-                    g = get_gain(si2, sf2, um, T);
-                    if(g < 0)
-                        return 1;
-                    get_time(si2, sf2, fabs(g*um), u2, ts2);
-                    get_time(si1, sf1, fabs(um), u1, ts1);
-                }
-                // dim 1 needs to slow down
-                else
-                {
-                    g = get_gain(si1, sf1, um, T);
-                    if(g < 0)
-                        return 1;
-                    get_time(si1, sf1, fabs(g*um), u1, ts1); 
-                    get_time(si2, sf2, fabs(um), u2, ts2);
-                }
-
-                opt_data.ts1 = ts1;
-                opt_data.ts2 = ts2;
-                opt_data.u1 = u1;
-                opt_data.u2 = u2;
-                opt_data.is_initialized = true;
-            } 
+                g = get_gain(si2, sf2, um, T);
+                if(g < 0)
+                    return 1;
+                get_time(si2, sf2, fabs(g*um), u2, ts2);
+                get_time(si1, sf1, fabs(um), u1, ts1);
+            }
+            // dim 1 needs to slow down
             else
             {
-                ts1 = opt_data.ts1;
-                ts2 = opt_data.ts2;
-                u1 = opt_data.u1;
-                u2 = opt_data.u2;
+                g = get_gain(si1, sf1, um, T);
+                if(g < 0)
+                    return 1;
+                get_time(si1, sf1, fabs(g*um), u1, ts1); 
+                get_time(si2, sf2, fabs(um), u2, ts2);
             }
+
+            opt_data.ts1 = ts1;
+            opt_data.ts2 = ts2;
+            opt_data.u1 = u1;
+            opt_data.u2 = u2;
+            opt_data.is_initialized = true;
+            return 0;
+        }
+
+        // one step of dt under the controls of opt_data at time t
+        void integrate(state_t& sc, control_t& cc, double t, double dt,
+                const double_integrator_opt_data_t& opt_data)
+        {
+            if(t < opt_data.ts1)
+                cc.x[0] = opt_data.u1;
+            else
+                cc.x[0] = -opt_data.u1;
+            if(t < opt_data.ts2)
+                cc.x[1] = opt_data.u2;
+            else
+                cc.x[1] = -opt_data.u2;
+
+            sc.x[2] += cc.x[0]*dt;
+            sc.x[0] += sc.x[2]*dt;
+
+            sc.x[3] += cc.x[1]*dt;
+            sc.x[1] += sc.x[3]*dt;
+        }
+
+        int extend_to(const state_t& si, const state_t& sf,
+                trajectory_t& traj, double_integrator_opt_data_t& opt_data)
+        {
+            if(evaluate_extend_cost(si, sf, opt_data) < 0)
+                return 1;
+
+            traj.clear();
+            traj.total_variation = opt_data.T;
+            if(get_controls(si, sf, opt_data))
+                return 1;
+
+            double T = opt_data.T;
             double t = 0, dt = 0.1;
             traj.dt = dt;
             state_t sc = si;
@@ -109,21 +133,7 @@ class double_integrator_c : public dynamical_system_c<state_c<4>, control_c<2>,
             traj.states.push_back(sc);
             while(t < T)
             {
-                if(t < ts1)
-                    cc.x[0] = u1;
-                else
-                    cc.x[0] = -u1;
-                if(t < ts2)
-                    cc.x[1] = u2;
-                else
-                    cc.x[1] = -u2;
-
-                sc.x[2] += cc.x[0]*dt;
-                sc.x[0] += sc.x[2]*dt;
-
-                sc.x[3] += cc.x[1]*dt;
-                sc.x[1] += sc.x[3]*dt;
-                
+                integrate(sc, cc, t, dt, opt_data);
                 traj.states.push_back(sc);
                 traj.controls.push_back(cc);
                 t += dt;
@@ -131,6 +141,34 @@ class double_integrator_c : public dynamical_system_c<state_c<4>, control_c<2>,
             return 0;
         }
 
+        int steer(const state_t& si, const state_t& sf, double_integrator_opt_data_t& opt_data,
+                size_t stride, const state_block_callback_t& cb)
+        {
+            if(evaluate_extend_cost(si, sf, opt_data) < 0)
+                return 1;
+            if(get_controls(si, sf, opt_data))
+                return 1;
+
+            double T = opt_data.T;
+            double t = 0, dt = 0.1;
+            state_t sc = si;
+            control_t cc;
+
+            state_block_writer_c<4> writer(cb);
+            if(int res = writer.push(sc.x))
+                return res;
+            for(size_t i=1; t < T; i++)
+            {
+                integrate(sc, cc, t, dt, opt_data);
+                t += dt;
+                if(i % stride)
+                    continue;
+                if(int res = writer.push(sc.x))
+                    return res;
+            }
+            return writer.flush();
+        }
+
         //use control g*um to reach origin from x0[2] in T time units
         double get_f(const double x0[2], const double xf[2],
                 const double g, const double um, const double T)
@@ -178,10 +216,10 @@ class double_integrator_c : public dynamical_system_c<state_c<4>, control_c<2>,
                     fm = get_f(x0, xf, gm, um, T);
                 }
 
+                // eps is halved on every retry above, the bracket may stop
+                // shrinking before it is that small
                 c++;
-                if(c > 100)
-                    cout<<"g: "<< g << " fm: "<< fm <<" fp: "<< fp <<" f: "<< f << endl;
-                is_converged = (gp-gm) < eps;
+                is_converged = ((gp-gm) < eps) || (c > 100);
             }
             return g;
         }
@@ -234,13 +272,15 @@ class double_integrator_c : public dynamical_system_c<state_c<4>, control_c<2>,
 
             double T1 = get_time(si1, sf1, um, u1, ts1);
             double T2 = get_time(si2, sf2, um, u1, ts2);
-            double T = max(T1, T2);
-            if(T < 0)
+            // both axes have to reach sf, get_controls reads both
+            // switching times
+            if((T1 < 0) || (T2 < 0))
                 return -1;
+            double T = max(T1, T2);
             
             //cout<<endl;
-            //si.print(cout, "si: ", "\n");
-            //sf.print(cout, "sf: ", "\n");
+            //print_state(si, cout, "si: ", "\n");
+            //print_state(sf, cout, "sf: ", "\n");
             //cout<<"T1: "<< T1 << " T2: "<< T2 << " T: "<< T << endl;
 
             opt_data.T1 = T1;
@@ -259,7 +299,7 @@ class double_integrator_c : public dynamical_system_c<state_c<4>, control_c<2>,
             state_t s1(s1t);
             double s2t[4] = {10, 10, 10, 10};
             state_t s2(s2t);
-            s2.print(cout, "sampled:","\n");
+            print_state(s2, cout, "sampled:", "\n");
 
             double_integrator_optimization_data_c opt_data;
             evaluate_extend_cost(s2, s1, opt_data);
@@ -272,7 +312,7 @@ class double_integrator_c : public dynamical_system_c<state_c<4>, control_c<2>,
             /*
                double g2[4] = {12, 4, 1, -1};
                state_t sg2(g2);
-               sg2.print(cout, "second goal:","\n");
+               print_state(sg2, cout, "second goal:", "\n");
 
                double_integrator_optimization_data_c opt_data2;
                if(extend_to(sr, sg2, traj2, opt_data2))
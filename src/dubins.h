@@ -12,7 +12,9 @@ class dubins_optimization_data_c : public optimization_data_c
 {
     public:
         int turning_radius;
-        dubins_optimization_data_c() : turning_radius(-1){}
+        // path length for turning_radius, without the penalty on tight turns
+        double length;
+        dubins_optimization_data_c() : turning_radius(-1), length(-1){}
         ~dubins_optimization_data_c(){}
 };
 
@@ -66,10 +68,11 @@ class dubins_c : public dynamical_system_c<state_c<3>, control_c<1>, dubins_opti
             return 0;
         }
 
-        int sample_state(double* center, double* size, double* s)
+        int sample_state(double* center, double* size, double* s, random_c& rng)
         {
+            rng.uniform(s, 3);
             for(int i : range(0,3))
-                s[i] = center[i] + (RANDF-0.5)*size[i];
+                s[i] = center[i] + (s[i]-0.5)*size[i];
             return 0;
         }
 
@@ -114,16 +117,62 @@ class dubins_c : public dynamical_system_c<state_c<3>, control_c<1>, dubins_opti
             return 0;
         }
 
+        // samples only the states that are handed out
+        int steer(const state_t& si, const state_t& sf, dubins_optimization_data_t& opt_data,
+                size_t stride, const state_block_callback_t& cb)
+        {
+            if(opt_data.turning_radius < 0)
+            {
+                if(evaluate_extend_cost(si, sf, opt_data) < 0)
+                    return 1;
+            }
+            double tr = turning_radii[opt_data.turning_radius];
+
+            DubinsPath path;
+            dubins_init(si.x, sf.x, tr, &path);
+            double length = dubins_path_length(&path);
+
+            state_block_writer_c<3> writer(cb);
+            double q[3];
+            size_t i = 0;
+            for(double x=0; x<length; x+=delta_distance, i++)
+            {
+                if(i % stride)
+                    continue;
+                dubins_path_sample(&path, x, q);
+                if(int res = writer.push(q))
+                    return res;
+            }
+            return writer.flush();
+        }
+
+        size_t get_euclidean_bound_dim()
+        {
+            return 2;
+        }
+        // no path is shorter than the dubins path with the smallest turning
+        // radius, and evaluate_extend_cost charges at least the length
+        double evaluate_cost_lower_bound(const state_t& si, const state_t& sf)
+        {
+            double tr = turning_radii[0];
+            for(int i=1; i<num_turning_radii; i++)
+                tr = min(tr, turning_radii[i]);
+            DubinsPath path;
+            if(dubins_init(si.x, sf.x, tr, &path))
+                return si.dist(sf, true);
+            return dubins_path_length(&path);
+        }
+
         double evaluate_extend_cost(const state_t& si, const state_t& sf,
                 dubins_optimization_data_t& opt_data)
         {
-            trajectory_t traj;
             if(opt_data.turning_radius >= 0)
             {
                 double tr = turning_radii[opt_data.turning_radius];
                 DubinsPath path;
                 dubins_init(si.x, sf.x, tr, &path);
-                return dubins_path_length(&path);
+                opt_data.length = dubins_path_length(&path);
+                return opt_data.length;
             }
             else
             {
@@ -148,6 +197,7 @@ class dubins_c : public dynamical_system_c<state_c<3>, control_c<1>, dubins_opti
                         {
                             min_cost = cost;
                             best_turning_radius = i;
+                            opt_data.length = T;
                         }
                     }
                 }
@@ -157,6 +207,20 @@ class dubins_c : public dynamical_system_c<state_c<3>, control_c<1>, dubins_opti
             }
         }
 
+        // the length of the path, which extend_to samples, not its cost
+        double evaluate_extend_duration(const state_t& si, const state_t& sf,
+                dubins_optimization_data_t& opt_data)
+        {
+            if(opt_data.turning_radius < 0)
+            {
+                if(evaluate_extend_cost(si, sf, opt_data) < 0)
+                    return -1;
+            }
+            else if(opt_data.length < 0)
+                return evaluate_extend_cost(si, sf, opt_data);
+            return opt_data.length;
+        }
+
         void test_extend_to()
         {
             trajectory_t traj;
@@ -164,7 +228,7 @@ class dubins_c : public dynamical_system_c<state_c<3>, control_c<1>, dubins_opti
             state_t origin(zero);
             double goal[3] = {10, 10, M_PI/2. + 0.01};
             state_t sr(goal);
-            sr.print(cout, "sampled:","\n");
+            print_state(sr, cout, "sampled:", "\n");
 
             dubins_optimization_data_c opt_data;
             extend_to(origin, sr, traj, opt_data);
@@ -59,11 +59,12 @@ class dubins_velocity_c : public dynamical_system_c<state_c<4>, control_c<2>, du
             return 0;
         }
 
-        int sample_state(double* center, double* size, double* s)
+        int sample_state(double* center, double* size, double* s, random_c& rng)
         {
+            rng.uniform(s, 3);
             for(int i : range(0,3))
-                s[i] = center[i] + (RANDF-0.5)*size[i];
-            int p = RANDF*4.0; 
+                s[i] = center[i] + (s[i]-0.5)*size[i];
+            int p = rng.uniform_int(4);
             s[3] = velocities[p];
 
             while(s[2] > M_PI)
@@ -399,7 +400,7 @@ class dubins_velocity_c : public dynamical_system_c<state_c<4>, control_c<2>, du
             state_t origin(zero);
             double goal[4] = {10, 2, M_PI/4, 1};
             state_t sr(goal);
-            sr.print(cout, "sampled:","\n");
+            print_state(sr, cout, "sampled:", "\n");
 
             dubins_velocity_optimization_data_c opt_data;
             extend_to(origin, sr, traj, opt_data);
@@ -7,11 +7,70 @@
 #include <list>
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <functional>
 #include "utils.h"
+#include "random.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
+/*
+ * Coordinate kernels of state_c. With SSE2 they work on pairs of
+ * coordinates, the odd one of N=3 is handled on its own.
+ */
+template<size_t N>
+inline void state_add(double* r, const double* a, const double* b)
+{
+    size_t i=0;
+#ifdef __SSE2__
+    for(; i+1<N; i+=2)
+        _mm_storeu_pd(r+i, _mm_add_pd(_mm_loadu_pd(a+i), _mm_loadu_pd(b+i)));
+#endif
+    for(; i<N; i++)
+        r[i] = a[i] + b[i];
+}
+template<size_t N>
+inline void state_sub(double* r, const double* a, const double* b)
+{
+    size_t i=0;
+#ifdef __SSE2__
+    for(; i+1<N; i+=2)
+        _mm_storeu_pd(r+i, _mm_sub_pd(_mm_loadu_pd(a+i), _mm_loadu_pd(b+i)));
+#endif
+    for(; i<N; i++)
+        r[i] = a[i] - b[i];
+}
+// squared distance over the first len <= N coordinates
+template<size_t N>
+inline double state_sq_dist(const double* a, const double* b, size_t len=N)
+{
+    double t=0;
+    size_t i=0;
+#ifdef __SSE2__
+    __m128d acc = _mm_setzero_pd();
+    for(; i+1<len; i+=2)
+    {
+        __m128d d = _mm_sub_pd(_mm_loadu_pd(a+i), _mm_loadu_pd(b+i));
+        acc = _mm_add_pd(acc, _mm_mul_pd(d, d));
+    }
+    t = _mm_cvtsd_f64(_mm_add_sd(acc, _mm_unpackhi_pd(acc, acc)));
+#endif
+    for(; i<len; i++)
+        t = t + SQ(a[i]-b[i]);
+    return t;
+}
+
+/*
+ * A state is N doubles and nothing else: no vtable, implicit copies, so it
+ * is trivially copyable and vectors of states grow with memmove. Even
+ * dimensions are 16 byte aligned for the SSE2 kernels, odd ones keep the
+ * alignment of double so a Dubins state stays 24 bytes. Print with
+ * print_state() or operator<<.
+ */
 template<size_t N_t>
-class state_c
+class alignas((N_t % 2) ? alignof(double) : 16) state_c
 {
     public:
         const static size_t N = N_t;
@@ -22,37 +81,20 @@ class state_c
             for(size_t i=0; i<N; i++)
                 x[i] = 0;
         }
-        state_c(const state_c& s)
-        {
-            for(size_t i=0; i<N; i++)
-                x[i] = s.x[i];
-        }
         state_c(const double* sin)
         {
-            for(size_t i=0; i<N; i++)
-                x[i] = sin[i];
-        }
-        state_c& operator=(const state_c& sin)
-        {
-            if(this == &sin)
-                return *this;
-            for(size_t i=0; i<N; i++)
-                x[i] = sin.x[i];
-            return *this;
+            memcpy(x, sin, N*sizeof(double));
         }
         state_c operator+(const state_c& s2) const
         {
-            state_c toret = *this;
-            for(size_t i=0; i<N; i++)
-                toret.x[i] += s2.x[i];
-
+            state_c toret;
+            state_add<N>(toret.x, x, s2.x);
             return toret;
         }
         state_c operator-(const state_c& s2) const
         {
-            state_c toret = *this;
-            for(size_t i=0; i<N; i++)
-                toret.x[i] -= s2.x[i];
+            state_c toret;
+            state_sub<N>(toret.x, x, s2.x);
             return toret;
         }
 
@@ -61,35 +103,35 @@ class state_c
             assert((i < N) && (i >= 0));
             return x[i];
         }
-        virtual ostream& print(ostream& os=cout, const char* prefix=NULL, const char* suffix=NULL) const
-        {
-            if(prefix)
-                os<<prefix<<" ";
-            for(size_t i=0; i<N-1; i++)
-                os<<x[i]<<",";
-            os<<x[N-1];
-            if(suffix)
-                os<<suffix;
-            return os;
-        }
         double dist(const state_c& s, bool only_xy=false) const
         {
-            size_t len = N;
-            if(only_xy)
-                len = 2;
-            double t=0;
-            for(size_t i=0; i<len; i++)
-                t = t + SQ(x[i]-s.x[i]);
-            return sqrt(t);
+            return sqrt(state_sq_dist<N>(x, s.x, only_xy ? 2 : N));
         }
 };
 
+template<size_t N>
+ostream& print_state(const state_c<N>& s, ostream& os=cout, const char* prefix=NULL, const char* suffix=NULL)
+{
+    if(prefix)
+        os<<prefix<<" ";
+    for(size_t i=0; i<N-1; i++)
+        os<<s.x[i]<<",";
+    os<<s.x[N-1];
+    if(suffix)
+        os<<suffix;
+    return os;
+}
+template<size_t N>
+ostream& operator<<(ostream& os, const state_c<N>& s)
+{
+    return print_state(s, os);
+}
+
 template<size_t M>
 class control_c : public state_c<M>
 {
     public:
         control_c() : state_c<M>() {}
-        control_c(const control_c& c) : state_c<M>(c) {};
         control_c(const double* cin) : state_c<M>(cin) {};
 };
 
@@ -122,7 +164,7 @@ class trajectory_c
             controls = vector<control_t>(controls.begin()+how_many, controls.end());
             return 0;
         }
-        int append(trajectory_c& t2)
+        int append(const trajectory_c& t2)
         {
             //if(dt > 1e-3)
             //assert( fabs(dt - t2.dt) < 1e-3);
@@ -148,18 +190,54 @@ class trajectory_c
         {
             cout<<prefix<<endl;
             for(auto& s : states)
-                s.print(cout, "", "\n");
+                print_state(s, cout, "", "\n");
             return 0;
         }
         int print_controls(const char* prefix="")
         {
             cout<<prefix<<endl;
             for(auto& c : controls)
-                c.print(cout, "", "\n");
+                print_state(c, cout, "", "\n");
             return 0;
         }
 };
 
+/*
+ * Receives count states of a trajectory from dynamical_system_c::steer,
+ * state i at states[i*N .. i*N+N). A non-zero return stops the steering.
+ */
+typedef function<int(const double* states, size_t count)> state_block_callback_t;
+
+// collects states and hands them to a state_block_callback_t in blocks
+template<size_t N>
+class state_block_writer_c
+{
+    public:
+        const static size_t block_size = 64;
+
+        state_block_writer_c(const state_block_callback_t& cb_in) : cb(cb_in), count(0) {}
+
+        // returns the value of the callback if it stopped the steering
+        int push(const double* s)
+        {
+            memcpy(states + count*N, s, N*sizeof(double));
+            if(++count == block_size)
+                return flush();
+            return 0;
+        }
+        int flush()
+        {
+            size_t c = count;
+            count = 0;
+            return c ? cb(states, c) : 0;
+        }
+
+    protected:
+        const state_block_callback_t& cb;
+        size_t count;
+        double states[block_size*N];
+};
+
 class optimization_data_c
 {
     public:
@@ -192,10 +270,52 @@ class dynamical_system_c
             return 0;
         }
 
-        virtual int sample_state(double* center, double* size, double* s) = 0;
+        virtual int sample_state(double* center, double* size, double* s, random_c& rng) = 0;
 
         virtual int extend_to(const state_t& si, const state_t& sf, trajectory_t& traj, opt_data_t& opt_data)=0;
         virtual double evaluate_extend_cost(const state_t& si, const state_t& sf, opt_data_t& opt_data)=0;
+        // duration of the trajectory from si to sf once evaluate_extend_cost
+        // has filled opt_data, used as the dt of edges. Systems whose cost
+        // is not the duration, or that can keep it in opt_data, override it.
+        virtual double evaluate_extend_duration(const state_t& si, const state_t& sf, opt_data_t& opt_data)
+        {
+            return evaluate_extend_cost(si, sf, opt_data);
+        }
+
+        // the cost of every trajectory is at least the Euclidean distance
+        // over this many leading coordinates, 0 if there is no such bound
+        virtual size_t get_euclidean_bound_dim()
+        {
+            return 0;
+        }
+        // admissible lower bound on the cost from si to sf, used by
+        // informed sampling. Systems with a tighter bound override it.
+        virtual double evaluate_cost_lower_bound(const state_t& si, const state_t& sf)
+        {
+            double t = 0;
+            for(size_t i=0; i<get_euclidean_bound_dim(); i++)
+                t += SQ(si.x[i] - sf.x[i]);
+            return sqrt(t);
+        }
+
+        // hands every stride-th state of the trajectory extend_to would
+        // return to cb without building it, returns 1 if there is no
+        // trajectory and the value of cb if it stopped early. Systems
+        // override this to generate the states on the fly.
+        virtual int steer(const state_t& si, const state_t& sf, opt_data_t& opt_data,
+                size_t stride, const state_block_callback_t& cb)
+        {
+            trajectory_t traj;
+            if(extend_to(si, sf, traj, opt_data))
+                return 1;
+            state_block_writer_c<state_t::N> writer(cb);
+            for(size_t i=0; i<traj.states.size(); i+=stride)
+            {
+                if(int res = writer.push(traj.states[i].x))
+                    return res;
+            }
+            return writer.flush();
+        }
 
         virtual int get_plotter_state(const state_t& s, double* ps)=0;
 
@@ -0,0 +1,241 @@
+#ifndef __fmts_h__
+#define __fmts_h__
+
+#include <vector>
+#include <queue>
+#include <unordered_set>
+#include "rrts.h"
+using namespace std;
+
+/*
+ * Fast Marching Tree (FMT*, Janson et al.) on top of rrts_c. initialize()
+ * draws all num_samples samples up front. The tree then grows outward in
+ * one pass: the open vertex z with the lowest cost from the root is
+ * expanded by connecting every unvisited sample x near z to the open vertex
+ * y near x that minimizes g(y) + c(y,x). Only that edge is collision
+ * checked, x stays unvisited if it collides. No edge is rewired afterwards.
+ *
+ * Tree surgery (switch_root, check_tree, delete_downstream),
+ * lazy_collision_checking and rrts_c::iteration() are not available on
+ * this planner.
+ */
+template<class vertex_tt, class edge_tt,
+    class kdtree_tt = kdtree_c<vertex_tt::system_t::N, vertex_tt*> >
+class fmts_c : public rrts_c<vertex_tt, edge_tt, kdtree_tt>
+{
+    public:
+        typedef rrts_c<vertex_tt, edge_tt, kdtree_tt> rrts_t;
+
+        typedef typename rrts_t::system_t system_t;
+        typedef typename rrts_t::state state;
+        typedef typename rrts_t::opt_data_t opt_data_t;
+        typedef typename rrts_t::cost_t cost_t;
+        typedef typename rrts_t::vertex vertex;
+        typedef typename rrts_t::edge edge;
+        typedef typename rrts_t::kdtree_t kdtree_t;
+
+        const static size_t num_dim = rrts_t::num_dim;
+
+        size_t num_samples;
+        // stop once the cheapest open vertex is in the goal region,
+        // otherwise grow the tree over every reachable sample
+        bool stop_at_goal;
+
+        fmts_c(size_t num_samples_in=1000)
+        {
+            num_samples = num_samples_in;
+            stop_at_goal = true;
+        }
+        fmts_c(plotter_c* plotter_in, size_t num_samples_in=1000) : rrts_t(plotter_in)
+        {
+            num_samples = num_samples_in;
+            stop_at_goal = true;
+        }
+
+        // sets the root and draws the samples
+        int initialize(const state& rs)
+        {
+            samples.clear();
+            sample_kdtree.clear();
+            unvisited.clear();
+            open_set.clear();
+            open_queue = decltype(open_queue)();
+
+            if(rrts_t::initialize(rs, false))
+                return 1;
+            draw_samples();
+            push_open(*(this->root));
+            return 0;
+        }
+
+        // expands the cheapest open vertex. Returns 1 once the open set is
+        // empty and 2 if stop_at_goal is set and that vertex is in the goal.
+        int iteration()
+        {
+            if(open_queue.empty())
+                return 1;
+            vertex& z = *(open_queue.top().v);
+            if(stop_at_goal && this->system.is_in_goal(z.state))
+                return 2;
+            open_queue.pop();
+
+            this->last_added_vertex = NULL;
+            new_open.clear();
+            get_near(sample_kdtree, z.state, near_samples);
+            for(auto& px : near_samples)
+            {
+                if(unvisited.count(px))
+                    connect_sample(*px);
+            }
+
+            open_set.erase(&z);
+            for(auto& pv : new_open)
+                push_open(*pv);
+            return 0;
+        }
+
+        // runs iteration() until it stops, returns 0 if the goal was reached
+        int solve()
+        {
+            while(!iteration()) {};
+            return this->lower_bound_vertex ? 0 : 1;
+        }
+
+        size_t get_num_samples() const
+        {
+            return samples.size();
+        }
+        size_t get_num_open() const
+        {
+            return open_set.size();
+        }
+
+    protected:
+        struct open_entry_t
+        {
+            cost_t key;
+            vertex* v;
+        };
+        // cost_t::operator< is <=, the queue pops the smallest key first
+        struct compare_entries_t
+        {
+            bool operator()(const open_entry_t& e1, const open_entry_t& e2) const
+            {
+                return strictly_less(e2.key, e1.key);
+            }
+        };
+
+        // every sample, indexed by sample_kdtree, and those not yet in the tree
+        vector<vertex*> samples;
+        kdtree_t sample_kdtree;
+        unordered_set<vertex*> unvisited;
+        double near_radius;
+        size_t near_k;
+
+        // the costs of open vertices do not change, entries are never stale
+        priority_queue<open_entry_t, vector<open_entry_t>, compare_entries_t> open_queue;
+        unordered_set<vertex*> open_set;
+        // connected while expanding the current vertex, opened after it
+        vector<vertex*> new_open;
+        vector<vertex*> near_samples, near_vertices;
+
+        static bool strictly_less(const cost_t& c1, const cost_t& c2)
+        {
+            return (c1 < c2) && !(c2 < c1);
+        }
+
+        void push_open(vertex& v)
+        {
+            open_entry_t e;
+            e.key = v.cost_from_root;
+            e.v = &v;
+            open_queue.push(e);
+            open_set.insert(&v);
+        }
+
+        int get_near(const kdtree_t& tree, const state& s, vector<vertex*>& near)
+        {
+            double key[num_dim];
+            this->system.get_key(s, key);
+            near.clear();
+            if(this->use_k_nearest)
+                return tree.nearest_n(key, near_k, near);
+            return tree.near_range(key, near_radius, near);
+        }
+
+        int draw_samples()
+        {
+            for(size_t i=0; i<num_samples; i++)
+            {
+                state s;
+                int ret = 0;
+                if(this->system.rng.uniform() < this->goal_sample_freq)
+                    ret = this->system.sample_in_goal(s);
+                else
+                    ret = this->system.sample_state(s);
+                if(ret)
+                    continue;
+                vertex* px = this->vertex_pool.construct(s);
+                samples.push_back(px);
+                unvisited.insert(px);
+            }
+
+            sample_kdtree.reserve(samples.size());
+            double key[num_dim];
+            for(auto& px : samples)
+            {
+                this->system.get_key(px->state, key);
+                sample_kdtree.insert(key, px);
+            }
+
+            double q = samples.size() + 1.0;
+            near_radius = this->gamma*pow(this->system.get_informed_volume_fraction()*log(q + 1.0)/(q + 1.0),
+                    1.0/(double)num_dim);
+            near_k = ceil(this->k_rrt*log(q + 1.0));
+            return 0;
+        }
+
+        // connects x to its locally optimal open parent if that edge is free
+        int connect_sample(vertex& x)
+        {
+            get_near(this->kdtree, x.state, near_vertices);
+
+            vertex* best = NULL;
+            cost_t best_cost, best_edge_cost;
+            opt_data_t best_opt_data;
+            double best_dt = 0;
+            for(auto& py : near_vertices)
+            {
+                if(!open_set.count(py))
+                    continue;
+                opt_data_t opt_data;
+                cost_t edge_cost;
+                double dt;
+                if(this->system.evaluate_extend_cost(py->state, x.state, opt_data, edge_cost, dt))
+                    continue;
+                cost_t c = py->cost_from_root + edge_cost;
+                if(!best || strictly_less(c, best_cost))
+                {
+                    best = py;
+                    best_cost = c;
+                    best_edge_cost = edge_cost;
+                    best_opt_data = opt_data;
+                    best_dt = dt;
+                }
+            }
+            if(!best)
+                return 1;
+            if(!this->system.is_feasible(best->state, x.state, best_opt_data))
+                return 1;
+
+            edge* en = this->edge_pool.construct(&(best->state), &(x.state), best_edge_cost, best_dt, best_opt_data);
+            en->is_checked = true;
+            this->insert_into_kdtree(x);
+            this->insert_edge(*best, *en, x);
+            unvisited.erase(&x);
+            new_open.push_back(&x);
+            this->last_added_vertex = &x;
+            return 0;
+        }
+};
+#endif
@@ -0,0 +1,777 @@
+#ifndef __kd_tree_h__
+#define __kd_tree_h__
+
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdint.h>
+#include <atomic>
+#include "kdtree.h"
+using namespace std;
+
+/*
+ * Header-only kd-tree with compile-time dimension. Keys are stored inline
+ * in the nodes and all nodes live in one contiguous vector, children are
+ * addressed by 32-bit indices. Queries append to a caller-supplied vector
+ * and never allocate once the vector has grown to its working size.
+ *
+ * Nodes are split in insertion order, cycling through the dimensions like
+ * kdtree.c does, so the two policies return the same neighbors.
+ *
+ * erase() only marks a node dead and queries step over it. Once more than
+ * half of the nodes are dead the whole tree is rebuilt from the live ones.
+ * Every node counts the nodes below it, dead ones included. An insert that
+ * ends deeper than log(n)/log(1/balance) rebuilds the lowest subtree on its
+ * path with a child holding more than balance of its nodes around medians
+ * (scapegoat tree), dropping the dead nodes in it. Freed slots are reused
+ * by later inserts.
+ */
+template<size_t N_t, class data_tt>
+class kdtree_c
+{
+    public:
+        const static size_t N = N_t;
+        typedef data_tt data_t;
+
+        struct node_t
+        {
+            double key[N];
+            data_t data;
+            int32_t left, right;
+            // nodes in the subtree
+            int32_t size;
+            int16_t dir;
+            int16_t dead;
+        };
+
+        vector<node_t> nodes;
+
+        // 1 turns the partial rebuilds off
+        double balance;
+
+        kdtree_c() : balance(0.75), root(-1), num_dead(0) {}
+
+        void clear()
+        {
+            nodes.clear();
+            free_ids.clear();
+            root = -1;
+            num_dead = 0;
+        }
+        // live keys
+        size_t size() const
+        {
+            return nodes.size() - free_ids.size() - num_dead;
+        }
+        void reserve(size_t n)
+        {
+            nodes.reserve(n);
+        }
+
+        int insert(const double* key, const data_t& data)
+        {
+            int32_t id = new_node(key, data);
+            if(root < 0)
+            {
+                root = id;
+                return 0;
+            }
+
+            path.clear();
+            int32_t c = root;
+            while(true)
+            {
+                node_t& p = nodes[c];
+                p.size++;
+                path.push_back(c);
+                int32_t& next = (key[p.dir] < p.key[p.dir]) ? p.left : p.right;
+                if(next < 0)
+                {
+                    nodes[id].dir = (p.dir + 1) % N;
+                    next = id;
+                    break;
+                }
+                c = next;
+            }
+            if((balance < 1) && (path.size() > max_depth()))
+                rebuild_scapegoat(id);
+            return 0;
+        }
+
+        // marks the node with this key and data dead, returns 1 if there
+        // is none
+        int erase(const double* key, const data_t& data)
+        {
+            int32_t c = root;
+            while(c >= 0)
+            {
+                node_t& n = nodes[c];
+                if(!n.dead && (n.data == data) && equal_keys(n.key, key))
+                {
+                    n.dead = 1;
+                    num_dead++;
+                    if(2*num_dead > nodes.size() - free_ids.size())
+                        root = rebuild(root);
+                    return 0;
+                }
+                c = (key[n.dir] < n.key[n.dir]) ? n.left : n.right;
+            }
+            return 1;
+        }
+
+        // returns 1 if the tree is empty
+        int nearest(const double* key, data_t& data) const
+        {
+            if(root < 0)
+                return 1;
+            double off[N] = {0};
+            int32_t best = -1;
+            double best_d2 = DBL_MAX;
+            nearest_i(root, key, 0, off, best, best_d2);
+            if(best < 0)
+                return 1;
+            data = nodes[best].data;
+            return 0;
+        }
+
+        // appends all elements within distance range of key to near
+        int near_range(const double* key, double range, vector<data_t>& near) const
+        {
+            if(root < 0)
+                return 0;
+            double off[N] = {0};
+            size_t n0 = near.size();
+            range_i(root, key, range*range, 0, off, near);
+            return near.size() - n0;
+        }
+
+        // appends the k elements closest to key to near, in order of
+        // increasing distance. Uses a scratch heap owned by the tree.
+        int nearest_n(const double* key, size_t k, vector<data_t>& near) const
+        {
+            if((root < 0) || !k)
+                return 0;
+            double off[N] = {0};
+            heap.clear();
+            nearest_n_i(root, key, k, 0, off);
+
+            sort_heap(heap.begin(), heap.end());
+            for(auto& h : heap)
+                near.push_back(nodes[h.second].data);
+            return heap.size();
+        }
+
+    protected:
+        int32_t root;
+        size_t num_dead;
+        vector<int32_t> free_ids;
+        // scratch of insert and rebuild
+        vector<int32_t> path, stack, ids;
+        vector<node_t> items;
+        mutable vector<pair<double, int32_t> > heap;
+
+        static double dist_sq(const double* k1, const double* k2)
+        {
+            double t = 0;
+            for(size_t i=0; i<N; i++)
+                t += (k1[i]-k2[i])*(k1[i]-k2[i]);
+            return t;
+        }
+        static bool equal_keys(const double* k1, const double* k2)
+        {
+            for(size_t i=0; i<N; i++)
+            {
+                if(k1[i] != k2[i])
+                    return false;
+            }
+            return true;
+        }
+
+        int32_t new_node(const double* key, const data_t& data)
+        {
+            int32_t id;
+            if(free_ids.empty())
+            {
+                id = (int32_t)nodes.size();
+                nodes.push_back(node_t());
+            }
+            else
+            {
+                id = free_ids.back();
+                free_ids.pop_back();
+            }
+            node_t& n = nodes[id];
+            for(size_t i=0; i<N; i++)
+                n.key[i] = key[i];
+            n.data = data;
+            n.left = n.right = -1;
+            n.size = 1;
+            n.dir = 0;
+            n.dead = 0;
+            return id;
+        }
+
+        size_t max_depth() const
+        {
+            return log((double)(nodes.size() - free_ids.size()))/log(1/balance);
+        }
+
+        // id was just inserted below path
+        void rebuild_scapegoat(int32_t id)
+        {
+            int32_t c = id;
+            for(size_t i=path.size(); i-- > 0; )
+            {
+                int32_t pi = path[i];
+                int32_t old_size = nodes[pi].size;
+                if(nodes[c].size > balance*old_size)
+                {
+                    int32_t nr = rebuild(pi);
+                    if(!i)
+                        root = nr;
+                    else
+                    {
+                        node_t& pp = nodes[path[i-1]];
+                        (pp.left == pi ? pp.left : pp.right) = nr;
+                    }
+                    int32_t dropped = old_size - ((nr < 0) ? 0 : nodes[nr].size);
+                    for(size_t j=0; j<i; j++)
+                        nodes[path[j]].size -= dropped;
+                    return;
+                }
+                c = pi;
+            }
+        }
+
+        // rebuilds the subtree at ni around medians in the slots of its
+        // live nodes and frees the slots of the dead ones. Returns the new
+        // root of the subtree, -1 if nothing in it was alive.
+        int32_t rebuild(int32_t ni)
+        {
+            int dir = nodes[ni].dir;
+            ids.clear();
+            items.clear();
+            stack.clear();
+            stack.push_back(ni);
+            while(!stack.empty())
+            {
+                int32_t c = stack.back();
+                stack.pop_back();
+                const node_t& n = nodes[c];
+                if(n.left >= 0)
+                    stack.push_back(n.left);
+                if(n.right >= 0)
+                    stack.push_back(n.right);
+                if(n.dead)
+                {
+                    free_ids.push_back(c);
+                    num_dead--;
+                }
+                else
+                {
+                    ids.push_back(c);
+                    items.push_back(n);
+                }
+            }
+            size_t next = 0;
+            return build(0, items.size(), dir, next);
+        }
+
+        // keys left of a node are smaller in its dimension, those right of
+        // it are not, as insert() and erase() expect
+        int32_t build(size_t lo, size_t hi, int dir, size_t& next)
+        {
+            if(lo >= hi)
+                return -1;
+            auto less_dir = [dir](const node_t& n1, const node_t& n2)
+            {
+                return n1.key[dir] < n2.key[dir];
+            };
+            size_t mid = lo + (hi-lo)/2;
+            nth_element(items.begin()+lo, items.begin()+mid, items.begin()+hi, less_dir);
+            double split = items[mid].key[dir];
+            size_t m = partition(items.begin()+lo, items.begin()+hi,
+                    [dir, split](const node_t& n){return n.key[dir] < split;}) - items.begin();
+            for(size_t i=m; i<hi; i++)
+            {
+                if(items[i].key[dir] == split)
+                {
+                    swap(items[m], items[i]);
+                    break;
+                }
+            }
+
+            int32_t id = ids[next++];
+            node_t& n = nodes[id];
+            n = items[m];
+            n.dir = dir;
+            n.size = hi - lo;
+            n.left = build(lo, m, (dir + 1) % N, next);
+            n.right = build(m+1, hi, (dir + 1) % N, next);
+            return id;
+        }
+
+        // off[] holds the per-dimension distance from the key to the cell
+        // of the current node, rd is its squared norm (Arya and Mount)
+        void nearest_i(int32_t ni, const double* key, double rd, double* off,
+                int32_t& best, double& best_d2) const
+        {
+            const node_t& n = nodes[ni];
+            if(!n.dead)
+            {
+                double d2 = dist_sq(n.key, key);
+                if(d2 < best_d2)
+                {
+                    best_d2 = d2;
+                    best = ni;
+                }
+            }
+
+            double diff = key[n.dir] - n.key[n.dir];
+            int32_t near_child = (diff < 0) ? n.left : n.right;
+            int32_t far_child = (diff < 0) ? n.right : n.left;
+            if(near_child >= 0)
+                nearest_i(near_child, key, rd, off, best, best_d2);
+            if(far_child >= 0)
+            {
+                double old_off = off[n.dir];
+                double far_rd = rd - old_off*old_off + diff*diff;
+                if(far_rd < best_d2)
+                {
+                    off[n.dir] = diff;
+                    nearest_i(far_child, key, far_rd, off, best, best_d2);
+                    off[n.dir] = old_off;
+                }
+            }
+        }
+
+        // heap is a max-heap on distance holding at most k nodes
+        void nearest_n_i(int32_t ni, const double* key, size_t k, double rd, double* off) const
+        {
+            const node_t& n = nodes[ni];
+            if(!n.dead)
+            {
+                double d2 = dist_sq(n.key, key);
+                if(heap.size() < k)
+                {
+                    heap.push_back(make_pair(d2, ni));
+                    push_heap(heap.begin(), heap.end());
+                }
+                else if(d2 < heap.front().first)
+                {
+                    pop_heap(heap.begin(), heap.end());
+                    heap.back() = make_pair(d2, ni);
+                    push_heap(heap.begin(), heap.end());
+                }
+            }
+
+            double diff = key[n.dir] - n.key[n.dir];
+            int32_t near_child = (diff < 0) ? n.left : n.right;
+            int32_t far_child = (diff < 0) ? n.right : n.left;
+            if(near_child >= 0)
+                nearest_n_i(near_child, key, k, rd, off);
+            if(far_child >= 0)
+            {
+                double old_off = off[n.dir];
+                double far_rd = rd - old_off*old_off + diff*diff;
+                if((heap.size() < k) || (far_rd < heap.front().first))
+                {
+                    off[n.dir] = diff;
+                    nearest_n_i(far_child, key, k, far_rd, off);
+                    off[n.dir] = old_off;
+                }
+            }
+        }
+
+        void range_i(int32_t ni, const double* key, double r2, double rd, double* off,
+                vector<data_t>& near) const
+        {
+            const node_t& n = nodes[ni];
+            if(!n.dead && (dist_sq(n.key, key) <= r2))
+                near.push_back(n.data);
+
+            double diff = key[n.dir] - n.key[n.dir];
+            int32_t near_child = (diff < 0) ? n.left : n.right;
+            int32_t far_child = (diff < 0) ? n.right : n.left;
+            if(near_child >= 0)
+                range_i(near_child, key, r2, rd, off, near);
+            if(far_child >= 0)
+            {
+                double old_off = off[n.dir];
+                double far_rd = rd - old_off*old_off + diff*diff;
+                if(far_rd <= r2)
+                {
+                    off[n.dir] = diff;
+                    range_i(far_child, key, r2, far_rd, off, near);
+                    off[n.dir] = old_off;
+                }
+            }
+        }
+};
+
+/*
+ * The same interface on top of the C kdtree.c implementation, can be
+ * passed to the planners instead of kdtree_c
+ */
+template<size_t N_t, class data_tt>
+class c_kdtree_c
+{
+    public:
+        const static size_t N = N_t;
+        typedef data_tt data_t;
+
+        struct kdtree* tree;
+        size_t num_nodes;
+
+        c_kdtree_c() : num_nodes(0)
+        {
+            tree = kd_create(N);
+        }
+        ~c_kdtree_c()
+        {
+            kd_free(tree);
+        }
+
+        void clear()
+        {
+            kd_clear(tree);
+            num_nodes = 0;
+        }
+        size_t size() const
+        {
+            return num_nodes;
+        }
+        void reserve(size_t n) {}
+
+        int insert(const double* key, const data_t& data)
+        {
+            if(kd_insert(tree, key, (void*)data))
+                return 1;
+            num_nodes++;
+            return 0;
+        }
+
+        // kdtree.c cannot delete, the caller rebuilds the tree
+        int erase(const double* key, const data_t& data)
+        {
+            return 1;
+        }
+
+        int nearest(const double* key, data_t& data) const
+        {
+            struct kdres* kdres = kd_nearest(tree, key);
+            if(!kdres)
+                return 1;
+            int toret = 0;
+            if(kd_res_end(kdres))
+                toret = 1;
+            else
+                data = (data_t) kd_res_item_data(kdres);
+            kd_res_free(kdres);
+            return toret;
+        }
+
+        int nearest_n(const double* key, size_t k, vector<data_t>& near) const
+        {
+            struct kdres* kdres = kd_nearest_n(tree, key, k);
+            if(!kdres)
+                return 0;
+            int num_near = kd_res_size(kdres);
+            while(!kd_res_end(kdres))
+            {
+                near.push_back((data_t) kd_res_item_data(kdres));
+                kd_res_next(kdres);
+            }
+            kd_res_free(kdres);
+            return num_near;
+        }
+
+        int near_range(const double* key, double range, vector<data_t>& near) const
+        {
+            struct kdres* kdres = kd_nearest_range(tree, key, range);
+            if(!kdres)
+                return 0;
+            int num_near = kd_res_size(kdres);
+            while(!kd_res_end(kdres))
+            {
+                near.push_back((data_t) kd_res_item_data(kdres));
+                kd_res_next(kdres);
+            }
+            kd_res_free(kdres);
+            return num_near;
+        }
+
+    private:
+        c_kdtree_c(const c_kdtree_c&);
+        c_kdtree_c& operator=(const c_kdtree_c&);
+};
+
+/*
+ * kd-tree that supports concurrent insert and query without locks. Nodes
+ * are never moved: they live in fixed-size blocks that are allocated on
+ * demand, a new node is filled in first and then published by a
+ * compare-and-swap on the child index of its parent. Queries only follow
+ * published links. The first key has to be inserted before the tree is
+ * shared between threads, clear() and get_data() must not run concurrently
+ * with inserts.
+ */
+template<size_t N_t, class data_tt>
+class concurrent_kdtree_c
+{
+    public:
+        const static size_t N = N_t;
+        typedef data_tt data_t;
+
+        const static size_t block_bits = 12;
+        const static size_t block_size = 1 << block_bits;
+        const static size_t max_blocks = 1 << 15;
+
+        struct node_t
+        {
+            double key[N];
+            data_t data;
+            atomic<int32_t> child[2];
+            int32_t dir;
+        };
+
+        concurrent_kdtree_c() : num_allocated(0), num_nodes(0)
+        {
+            blocks = new atomic<node_t*>[max_blocks];
+            for(size_t i=0; i<max_blocks; i++)
+                blocks[i].store(NULL);
+        }
+        ~concurrent_kdtree_c()
+        {
+            for(size_t i=0; i<max_blocks; i++)
+                delete[] blocks[i].load();
+            delete[] blocks;
+        }
+
+        // blocks are kept
+        void clear()
+        {
+            num_allocated.store(0);
+            num_nodes.store(0);
+        }
+        size_t size() const
+        {
+            return num_nodes.load(memory_order_acquire);
+        }
+        void reserve(size_t n)
+        {
+            for(size_t i=0; (i << block_bits) < n && i < max_blocks; i++)
+                get_block(i);
+        }
+
+        // returns 1 if the tree is full
+        int insert(const double* key, const data_t& data)
+        {
+            size_t id = num_allocated.fetch_add(1);
+            if(id >= max_blocks*block_size)
+                return 1;
+            node_t& n = get_block(id >> block_bits)[id & (block_size-1)];
+            for(size_t i=0; i<N; i++)
+                n.key[i] = key[i];
+            n.data = data;
+            n.child[0].store(-1, memory_order_relaxed);
+            n.child[1].store(-1, memory_order_relaxed);
+            n.dir = 0;
+
+            int32_t c = 0;
+            while(id)
+            {
+                node_t& p = node(c);
+                atomic<int32_t>& next = p.child[(key[p.dir] < p.key[p.dir]) ? 0 : 1];
+                int32_t t = next.load(memory_order_acquire);
+                if(t < 0)
+                {
+                    n.dir = (p.dir + 1) % N;
+                    if(next.compare_exchange_strong(t, (int32_t)id,
+                                memory_order_release, memory_order_acquire))
+                        break;
+                }
+                c = t;
+            }
+            num_nodes.fetch_add(1, memory_order_release);
+            return 0;
+        }
+
+        // nodes are never removed, the caller rebuilds the tree
+        int erase(const double* key, const data_t& data)
+        {
+            return 1;
+        }
+
+        // data of the i-th inserted key
+        const data_t& get_data(size_t i) const
+        {
+            return node(i).data;
+        }
+
+        int nearest(const double* key, data_t& data) const
+        {
+            if(!size())
+                return 1;
+            double off[N] = {0};
+            int32_t best = 0;
+            double best_d2 = DBL_MAX;
+            nearest_i(0, key, 0, off, best, best_d2);
+            data = node(best).data;
+            return 0;
+        }
+
+        int near_range(const double* key, double range, vector<data_t>& near) const
+        {
+            if(!size())
+                return 0;
+            double off[N] = {0};
+            size_t n0 = near.size();
+            range_i(0, key, range*range, 0, off, near);
+            return near.size() - n0;
+        }
+
+        // the scratch heap is per thread
+        int nearest_n(const double* key, size_t k, vector<data_t>& near) const
+        {
+            if(!size() || !k)
+                return 0;
+            static thread_local vector<pair<double, int32_t> > heap;
+            double off[N] = {0};
+            heap.clear();
+            nearest_n_i(0, key, k, 0, off, heap);
+
+            sort_heap(heap.begin(), heap.end());
+            for(auto& h : heap)
+                near.push_back(node(h.second).data);
+            return heap.size();
+        }
+
+    protected:
+        atomic<node_t*>* blocks;
+        atomic<size_t> num_allocated;
+        atomic<size_t> num_nodes;
+
+        node_t* get_block(size_t b)
+        {
+            node_t* nb = blocks[b].load(memory_order_acquire);
+            if(nb)
+                return nb;
+            node_t* t = new node_t[block_size];
+            if(blocks[b].compare_exchange_strong(nb, t, memory_order_acq_rel))
+                return t;
+            delete[] t;
+            return nb;
+        }
+        const node_t& node(size_t i) const
+        {
+            return blocks[i >> block_bits].load(memory_order_acquire)[i & (block_size-1)];
+        }
+        node_t& node(size_t i)
+        {
+            return blocks[i >> block_bits].load(memory_order_acquire)[i & (block_size-1)];
+        }
+
+        static double dist_sq(const double* k1, const double* k2)
+        {
+            double t = 0;
+            for(size_t i=0; i<N; i++)
+                t += (k1[i]-k2[i])*(k1[i]-k2[i]);
+            return t;
+        }
+
+        void nearest_i(int32_t ni, const double* key, double rd, double* off,
+                int32_t& best, double& best_d2) const
+        {
+            const node_t& n = node(ni);
+            double d2 = dist_sq(n.key, key);
+            if(d2 < best_d2)
+            {
+                best_d2 = d2;
+                best = ni;
+            }
+
+            double diff = key[n.dir] - n.key[n.dir];
+            int32_t near_child = n.child[(diff < 0) ? 0 : 1].load(memory_order_acquire);
+            int32_t far_child = n.child[(diff < 0) ? 1 : 0].load(memory_order_acquire);
+            if(near_child >= 0)
+                nearest_i(near_child, key, rd, off, best, best_d2);
+            if(far_child >= 0)
+            {
+                double old_off = off[n.dir];
+                double far_rd = rd - old_off*old_off + diff*diff;
+                if(far_rd < best_d2)
+                {
+                    off[n.dir] = diff;
+                    nearest_i(far_child, key, far_rd, off, best, best_d2);
+                    off[n.dir] = old_off;
+                }
+            }
+        }
+
+        void nearest_n_i(int32_t ni, const double* key, size_t k, double rd, double* off,
+                vector<pair<double, int32_t> >& heap) const
+        {
+            const node_t& n = node(ni);
+            double d2 = dist_sq(n.key, key);
+            if(heap.size() < k)
+            {
+                heap.push_back(make_pair(d2, ni));
+                push_heap(heap.begin(), heap.end());
+            }
+            else if(d2 < heap.front().first)
+            {
+                pop_heap(heap.begin(), heap.end());
+                heap.back() = make_pair(d2, ni);
+                push_heap(heap.begin(), heap.end());
+            }
+
+            double diff = key[n.dir] - n.key[n.dir];
+            int32_t near_child = n.child[(diff < 0) ? 0 : 1].load(memory_order_acquire);
+            int32_t far_child = n.child[(diff < 0) ? 1 : 0].load(memory_order_acquire);
+            if(near_child >= 0)
+                nearest_n_i(near_child, key, k, rd, off, heap);
+            if(far_child >= 0)
+            {
+                double old_off = off[n.dir];
+                double far_rd = rd - old_off*old_off + diff*diff;
+                if((heap.size() < k) || (far_rd < heap.front().first))
+                {
+                    off[n.dir] = diff;
+                    nearest_n_i(far_child, key, k, far_rd, off, heap);
+                    off[n.dir] = old_off;
+                }
+            }
+        }
+
+        void range_i(int32_t ni, const double* key, double r2, double rd, double* off,
+                vector<data_t>& near) const
+        {
+            const node_t& n = node(ni);
+            if(dist_sq(n.key, key) <= r2)
+                near.push_back(n.data);
+
+            double diff = key[n.dir] - n.key[n.dir];
+            int32_t near_child = n.child[(diff < 0) ? 0 : 1].load(memory_order_acquire);
+            int32_t far_child = n.child[(diff < 0) ? 1 : 0].load(memory_order_acquire);
+            if(near_child >= 0)
+                range_i(near_child, key, r2, rd, off, near);
+            if(far_child >= 0)
+            {
+                double old_off = off[n.dir];
+                double far_rd = rd - old_off*old_off + diff*diff;
+                if(far_rd <= r2)
+                {
+                    off[n.dir] = diff;
+                    range_i(far_child, key, r2, far_rd, off, near);
+                    off[n.dir] = old_off;
+                }
+            }
+        }
+
+    private:
+        concurrent_kdtree_c(const concurrent_kdtree_c&);
+        concurrent_kdtree_c& operator=(const concurrent_kdtree_c&);
+};
+
+#endif
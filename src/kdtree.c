@@ -287,56 +287,6 @@ static int find_nearest(struct kdnode *node, const double *pos, double range, st
   return added_res;
 }
 
-#if 0
-static int find_nearest_n(struct kdnode *node, const double *pos, double range, int num, struct rheap *heap, int dim)
-{
-  double dist_sq, dx;
-  int i, ret, added_res = 0;
-
-  if(!node) return 0;
-
-  /* if the photon is close enough, add it to the result heap */
-  dist_sq = 0;
-  for(i=0; i<dim; i++) {
-    dist_sq += SQ(node->pos[i] - pos[i]);
-  }
-  if(dist_sq <= range_sq) {
-    if(heap->size >= num) {
-      /* get furthest element */
-      struct res_node *maxelem = rheap_get_max(heap);
-
-      /* and check if the new one is closer than that */
-      if(maxelem->dist_sq > dist_sq) {
-        rheap_remove_max(heap);
-
-        if(rheap_insert(heap, node, dist_sq) == -1) {
-          return -1;
-        }
-        added_res = 1;
-
-        range_sq = dist_sq;
-      }
-    } else {
-      if(rheap_insert(heap, node, dist_sq) == -1) {
-        return =1;
-      }
-      added_res = 1;
-    }
-  }
-
-
-  /* find signed distance from the splitting plane */
-  dx = pos[node->dir] - node->pos[node->dir];
-
-  ret = find_nearest_n(dx <= 0.0 ? node->left : node->right, pos, range, num, heap, dim);
-  if(ret >= 0 && fabs(dx) < range) {
-    added_res += ret;
-    ret = find_nearest_n(dx <= 0.0 ? node->right : node->left, pos, range, num, heap, dim);
-  }
-
-}
-#endif
-
 static void kd_nearest_i(struct kdnode *node, const double *pos, struct kdnode **result, double *result_dist_sq, struct kdhyperrect* rect)
 {
   int dir = node->dir;
@@ -504,30 +454,125 @@ struct kdres *kd_nearest3f(struct kdtree *tree, float x, float y, float z)
 }
 
 /* ---- nearest N search ---- */
-/*
-   static kdres *kd_nearest_n(struct kdtree *kd, const double *pos, int num)
-   {
-   int ret;
-   struct kdres *rset;
-
-   if(!(rset = malloc(sizeof *rset))) {
-   return 0;
-   }
-   if(!(rset->rlist = alloc_resnode())) {
-   free(rset);
-   return 0;
-   }
-   rset->rlist->next = 0;
-   rset->tree = kd;
-
-   if((ret = find_nearest_n(kd->root, pos, range, num, rset->rlist, kd->dim)) == -1) {
-   kd_res_free(rset);
-   return 0;
-   }
-   rset->size = ret;
-   kd_res_rewind(rset);
-   return rset;
-   }*/
+struct rheap_item {
+  struct kdnode *item;
+  double dist_sq;
+};
+
+/* bounded max-heap on dist_sq, the root is the furthest of the kept nodes */
+struct rheap {
+  struct rheap_item *items;
+  int size, capacity;
+};
+
+static void rheap_sift_down(struct rheap *heap, int i)
+{
+  struct rheap_item tmp;
+  int c;
+
+  while((c = 2 * i + 1) < heap->size) {
+    if(c + 1 < heap->size && heap->items[c + 1].dist_sq > heap->items[c].dist_sq) {
+      c++;
+    }
+    if(heap->items[i].dist_sq >= heap->items[c].dist_sq) {
+      break;
+    }
+    tmp = heap->items[i];
+    heap->items[i] = heap->items[c];
+    heap->items[c] = tmp;
+    i = c;
+  }
+}
+
+static void rheap_insert(struct rheap *heap, struct kdnode *item, double dist_sq)
+{
+  struct rheap_item tmp;
+  int i, p;
+
+  if(heap->size < heap->capacity) {
+    i = heap->size++;
+    heap->items[i].item = item;
+    heap->items[i].dist_sq = dist_sq;
+    while(i > 0) {
+      p = (i - 1) / 2;
+      if(heap->items[p].dist_sq >= heap->items[i].dist_sq) {
+        break;
+      }
+      tmp = heap->items[i];
+      heap->items[i] = heap->items[p];
+      heap->items[p] = tmp;
+      i = p;
+    }
+  } else if(dist_sq < heap->items[0].dist_sq) {
+    heap->items[0].item = item;
+    heap->items[0].dist_sq = dist_sq;
+    rheap_sift_down(heap, 0);
+  }
+}
+
+static void find_nearest_n(struct kdnode *node, const double *pos, struct rheap *heap, int dim)
+{
+  double dist_sq, dx;
+  int i;
+
+  if(!node) return;
+
+  dist_sq = 0;
+  for(i=0; i<dim; i++) {
+    dist_sq += SQ(node->pos[i] - pos[i]);
+  }
+  rheap_insert(heap, node, dist_sq);
+
+  /* find signed distance from the splitting plane */
+  dx = pos[node->dir] - node->pos[node->dir];
+
+  find_nearest_n(dx <= 0.0 ? node->left : node->right, pos, heap, dim);
+  if(heap->size < heap->capacity || SQ(dx) < heap->items[0].dist_sq) {
+    find_nearest_n(dx <= 0.0 ? node->right : node->left, pos, heap, dim);
+  }
+}
+
+struct kdres *kd_nearest_n(struct kdtree *kd, const double *pos, int num)
+{
+  struct rheap heap;
+  struct kdres *rset;
+  int i;
+
+  if(!(rset = malloc(sizeof *rset))) {
+    return 0;
+  }
+  if(!(rset->rlist = alloc_resnode())) {
+    free(rset);
+    return 0;
+  }
+  rset->rlist->next = 0;
+  rset->tree = kd;
+  rset->size = 0;
+
+  if(num > 0) {
+    if(!(heap.items = malloc(num * sizeof *heap.items))) {
+      kd_res_free(rset);
+      return 0;
+    }
+    heap.size = 0;
+    heap.capacity = num;
+
+    find_nearest_n(kd->root, pos, &heap, kd->dim);
+
+    /* the result list is sorted by increasing distance */
+    for(i=0; i<heap.size; i++) {
+      if(rlist_insert(rset->rlist, heap.items[i].item, heap.items[i].dist_sq) == -1) {
+        free(heap.items);
+        kd_res_free(rset);
+        return 0;
+      }
+    }
+    rset->size = heap.size;
+    free(heap.items);
+  }
+  kd_res_rewind(rset);
+  return rset;
+}
 
 struct kdres *kd_nearest_range(struct kdtree *kd, const double *pos, double range)
 {
@@ -0,0 +1,54 @@
+#ifndef __lcmgl_plotter_h__
+#define __lcmgl_plotter_h__
+
+#include "plotter.h"
+
+#include <lcm/lcm.h>
+#include <bot_core/bot_core.h>
+#include <bot_lcmgl_client/lcmgl.h>
+#include <bot_vis/gl_util.h>
+
+/*
+ * Draws plot snapshots with libbot's lcmgl, the only part of the library
+ * that depends on LCM. Call bot_lcmgl_switch_buffer to publish a frame.
+ */
+class lcmgl_plotter_c : public plotter_c
+{
+    public:
+        bot_lcmgl_t* lcmgl;
+
+        lcmgl_plotter_c(bot_lcmgl_t* lcmgl_in) : lcmgl(lcmgl_in) {}
+
+        void draw(const plot_snapshot_c& snapshot)
+        {
+            if(!snapshot.boxes.empty())
+                bot_lcmgl_enable(lcmgl, GL_BLEND);
+            for(auto& b : snapshot.boxes)
+            {
+                float sf[3] = {(float)b.s[0], (float)b.s[1], (float)b.s[2]};
+                double c[3] = {b.c[0], b.c[1], b.c[2]};
+                bot_lcmgl_color4f(lcmgl, b.color[0], b.color[1], b.color[2], b.color[3]);
+                bot_lcmgl_box(lcmgl, c, sf);
+            }
+            for(auto& l : snapshot.lines)
+            {
+                bot_lcmgl_color4f(lcmgl, l.color[0], l.color[1], l.color[2], l.color[3]);
+                bot_lcmgl_line_width(lcmgl, l.width);
+                bot_lcmgl_begin(lcmgl, GL_LINES);
+                for(size_t i=0; i+2<l.xyz.size(); i+=3)
+                    bot_lcmgl_vertex3d(lcmgl, l.xyz[i], l.xyz[i+1], l.xyz[i+2]);
+                bot_lcmgl_end(lcmgl);
+            }
+            for(auto& p : snapshot.points)
+            {
+                bot_lcmgl_color4f(lcmgl, p.color[0], p.color[1], p.color[2], p.color[3]);
+                bot_lcmgl_point_size(lcmgl, p.size);
+                bot_lcmgl_begin(lcmgl, GL_POINTS);
+                for(size_t i=0; i+2<p.xyz.size(); i+=3)
+                    bot_lcmgl_vertex3d(lcmgl, p.xyz[i], p.xyz[i+1], p.xyz[i+2]);
+                bot_lcmgl_end(lcmgl);
+            }
+        }
+};
+
+#endif
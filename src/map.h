@@ -1,6 +1,9 @@
 #ifndef __map_h__
 #define __map_h__
 
+#include <cstddef>
+#include <stdint.h>
+
 template <size_t N> 
 class map_c
 {
@@ -16,6 +19,25 @@ class map_c
     {
       return false;
     }
+    // states are stored dimension-major, coordinate d of state i is
+    // states[d*count + i]. Sets out[i] to 1 if state i is in collision.
+    virtual int is_in_collision_batch(const double* states, size_t count, uint8_t* out)
+    {
+      double s[N];
+      for(size_t i=0; i<count; i++)
+      {
+        for(size_t d=0; d<N; d++)
+          s[d] = states[d*count + i];
+        out[i] = is_in_collision(s);
+      }
+      return 0;
+    }
+    // lower bound on the distance the state can move without entering an
+    // obstacle, 0 if it is in collision or the map cannot tell
+    virtual double get_clearance(const double s[N])
+    {
+      return 0;
+    }
     virtual double get_state_cost(const double s[N])
     { 
       return 0;
@@ -0,0 +1,397 @@
+#ifndef __occupancy_grid_h__
+#define __occupancy_grid_h__
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cmath>
+#include <cfloat>
+#include <stdint.h>
+#include "map.h"
+using namespace std;
+
+/*
+ * Occupancy grid over the first M (2 or 3) coordinates of the state, one
+ * bit per cell. Cell c covers [origin + c*resolution, origin + (c+1)*resolution)
+ * in every dimension and cells are stored with the first dimension
+ * running fastest. States outside the grid are in collision.
+ */
+template<size_t N, size_t M=2>
+class occupancy_grid_c : public map_c<N>
+{
+    public:
+        double origin[M];
+        double resolution;
+        int cells[M];
+        size_t stride[M];
+        size_t num_cells;
+        vector<uint64_t> bits;
+
+        occupancy_grid_c()
+        {
+            double zero[M] = {0};
+            int one[M];
+            for(size_t d=0; d<M; d++)
+                one[d] = 1;
+            resize(zero, one, 1);
+        }
+
+        // all cells are free after a resize
+        int resize(const double* origin_in, const int* cells_in, double resolution_in)
+        {
+            if(resolution_in <= 0)
+                return 1;
+            resolution = resolution_in;
+            num_cells = 1;
+            for(size_t d=0; d<M; d++)
+            {
+                if(cells_in[d] <= 0)
+                    return 1;
+                origin[d] = origin_in[d];
+                cells[d] = cells_in[d];
+                stride[d] = num_cells;
+                num_cells *= cells[d];
+            }
+            bits.assign((num_cells+63)/64, 0);
+            return 0;
+        }
+
+        // returns -1 outside the grid
+        long get_cell(const double* s) const
+        {
+            size_t id = 0;
+            for(size_t d=0; d<M; d++)
+            {
+                double t = floor((s[d] - origin[d])/resolution);
+                if((t < 0) || (t >= cells[d]))
+                    return -1;
+                id += (size_t)t*stride[d];
+            }
+            return id;
+        }
+        bool is_occupied_cell(size_t id) const
+        {
+            return (bits[id >> 6] >> (id & 63)) & 1;
+        }
+        void set_occupied_cell(size_t id, bool occupied=true)
+        {
+            if(occupied)
+                bits[id >> 6] |= (uint64_t)1 << (id & 63);
+            else
+                bits[id >> 6] &= ~((uint64_t)1 << (id & 63));
+        }
+        int set_occupied(const double* s, bool occupied=true)
+        {
+            long id = get_cell(s);
+            if(id < 0)
+                return 1;
+            set_occupied_cell(id, occupied);
+            return 0;
+        }
+        // marks every cell whose center lies in the box
+        int add_box(const double* center, const double* size)
+        {
+            int c0[M], c1[M];
+            for(size_t d=0; d<M; d++)
+            {
+                c0[d] = max(0, (int)ceil((center[d] - size[d]/2.0 - origin[d])/resolution - 0.5));
+                c1[d] = min(cells[d]-1, (int)floor((center[d] + size[d]/2.0 - origin[d])/resolution - 0.5));
+                if(c0[d] > c1[d])
+                    return 0;
+            }
+            int c[M];
+            for(size_t d=0; d<M; d++)
+                c[d] = c0[d];
+            while(true)
+            {
+                size_t id = 0;
+                for(size_t d=0; d<M; d++)
+                    id += c[d]*stride[d];
+                set_occupied_cell(id);
+
+                size_t d = 0;
+                for(; d<M; d++)
+                {
+                    if(++c[d] <= c1[d])
+                        break;
+                    c[d] = c0[d];
+                }
+                if(d == M)
+                    break;
+            }
+            return 0;
+        }
+
+        bool is_in_collision(const double s[N])
+        {
+            long id = get_cell(s);
+            return (id < 0) || is_occupied_cell(id);
+        }
+
+        int is_in_collision_batch(const double* states, size_t count, uint8_t* out)
+        {
+            double s[M];
+            for(size_t i=0; i<count; i++)
+            {
+                for(size_t d=0; d<M; d++)
+                    s[d] = states[d*count + i];
+                long id = get_cell(s);
+                out[i] = (id < 0) || is_occupied_cell(id);
+            }
+            return 0;
+        }
+
+        // loads a binary (P5) or ascii (P2) PGM image as a 2D grid, pixels
+        // darker than occupied_below*maxval are occupied. The first image
+        // row is the top of the map, i.e., the largest y.
+        int load_pgm(const char* filename, const double* origin_in, double resolution_in,
+                double occupied_below=0.5)
+        {
+            if(M != 2)
+                return 1;
+            ifstream f(filename, ios::binary);
+            if(!f)
+                return 2;
+
+            string magic;
+            int header[3];
+            f >> magic;
+            if((magic != "P5") && (magic != "P2"))
+                return 3;
+            for(int i=0; i<3; i++)
+            {
+                f >> ws;
+                while(f.peek() == '#')
+                {
+                    string comment;
+                    getline(f, comment);
+                    f >> ws;
+                }
+                if(!(f >> header[i]))
+                    return 3;
+            }
+            int width = header[0], height = header[1], maxval = header[2];
+            f.get();
+
+            int size_in[2] = {width, height};
+            if(resize(origin_in, size_in, resolution_in))
+                return 3;
+            double threshold = occupied_below*maxval;
+            for(int r=0; r<height; r++)
+            {
+                for(int c=0; c<width; c++)
+                {
+                    int v = 0;
+                    if(magic == "P2")
+                        f >> v;
+                    else
+                    {
+                        v = f.get();
+                        if(maxval > 255)
+                            v = (v << 8) | f.get();
+                    }
+                    if(!f)
+                        return 4;
+                    if(v < threshold)
+                        set_occupied_cell(c + (size_t)(height-1-r)*stride[1]);
+                }
+            }
+            return 0;
+        }
+
+        // binary layout: int32 M, int32 cells[M], double origin[M],
+        // double resolution, uint64 words of the bitset
+        int save_binary(const char* filename) const
+        {
+            ofstream f(filename, ios::binary);
+            if(!f)
+                return 1;
+            int32_t m = M;
+            int32_t c[M];
+            for(size_t d=0; d<M; d++)
+                c[d] = cells[d];
+            f.write((const char*)&m, sizeof(m));
+            f.write((const char*)c, sizeof(c));
+            f.write((const char*)origin, sizeof(origin));
+            f.write((const char*)&resolution, sizeof(resolution));
+            f.write((const char*)&bits[0], bits.size()*sizeof(uint64_t));
+            return f ? 0 : 2;
+        }
+        int load_binary(const char* filename)
+        {
+            ifstream f(filename, ios::binary);
+            if(!f)
+                return 1;
+            int32_t m = 0;
+            int32_t c[M];
+            double o[M], r = 0;
+            f.read((char*)&m, sizeof(m));
+            if(m != (int32_t)M)
+                return 2;
+            f.read((char*)c, sizeof(c));
+            f.read((char*)o, sizeof(o));
+            f.read((char*)&r, sizeof(r));
+            int ci[M];
+            for(size_t d=0; d<M; d++)
+                ci[d] = c[d];
+            if(!f || resize(o, ci, r))
+                return 2;
+            f.read((char*)&bits[0], bits.size()*sizeof(uint64_t));
+            return f ? 0 : 3;
+        }
+};
+
+/*
+ * Occupancy grid with a precomputed Euclidean distance transform: the
+ * distance of a state is the distance from the center of its cell to the
+ * center of the closest occupied cell, looked up in O(1). Call
+ * compute_distance_field() after the grid has been filled in.
+ *
+ * A state is in collision if its distance is at most robot_radius, the
+ * state cost rises linearly from 0 at cost_distance to cost_weight on an
+ * obstacle.
+ */
+template<size_t N, size_t M=2>
+class distance_field_c : public occupancy_grid_c<N, M>
+{
+    public:
+        typedef occupancy_grid_c<N, M> occupancy_grid_t;
+
+        vector<float> distance;
+        double robot_radius;
+        double cost_weight;
+        double cost_distance;
+
+        distance_field_c()
+        {
+            robot_radius = 0;
+            cost_weight = 1;
+            cost_distance = 1;
+        }
+
+        // Felzenszwalb and Huttenlocher, one pass of the 1D transform of
+        // squared distances per dimension
+        int compute_distance_field()
+        {
+            size_t n = this->num_cells;
+            const double far = 1e20;
+            vector<double> f(n);
+            for(size_t i=0; i<n; i++)
+                f[i] = this->is_occupied_cell(i) ? 0 : far;
+
+            int max_cells = 0;
+            for(size_t d=0; d<M; d++)
+                max_cells = max(max_cells, this->cells[d]);
+            vector<double> line(max_cells), out(max_cells), z(max_cells+1);
+            vector<int> v(max_cells);
+
+            for(size_t d=0; d<M; d++)
+            {
+                size_t len = this->cells[d];
+                size_t step = this->stride[d];
+                for(size_t start=0; start<n; start++)
+                {
+                    // visit each line along d once, from its first cell
+                    if((start/step) % len)
+                        continue;
+                    for(size_t q=0; q<len; q++)
+                        line[q] = f[start + q*step];
+                    edt_1d(&line[0], len, &out[0], &v[0], &z[0]);
+                    for(size_t q=0; q<len; q++)
+                        f[start + q*step] = out[q];
+                }
+            }
+
+            distance.resize(n);
+            for(size_t i=0; i<n; i++)
+                distance[i] = sqrt(f[i])*this->resolution;
+            return 0;
+        }
+
+        // distance to the closest occupied cell, 0 outside the grid
+        double get_distance(const double s[N])
+        {
+            long id = this->get_cell(s);
+            if((id < 0) || distance.empty())
+                return 0;
+            return distance[id];
+        }
+
+        // distances are between cell centers, so the state and the obstacle
+        // may each be half a cell diagonal closer than the stored value.
+        // States outside the grid are in collision, so the clearance also
+        // stops at its border.
+        double get_clearance(const double s[N])
+        {
+            double c = get_distance(s) - robot_radius - this->resolution*sqrt((double)M);
+            for(size_t d=0; d<M; d++)
+            {
+                double lo = s[d] - this->origin[d];
+                double hi = this->origin[d] + this->cells[d]*this->resolution - s[d];
+                c = min(c, min(lo, hi));
+            }
+            return max(c, 0.0);
+        }
+
+        bool is_in_collision(const double s[N])
+        {
+            if(distance.empty())
+                return occupancy_grid_t::is_in_collision(s);
+            return get_distance(s) <= robot_radius;
+        }
+
+        int is_in_collision_batch(const double* states, size_t count, uint8_t* out)
+        {
+            if(distance.empty())
+                return occupancy_grid_t::is_in_collision_batch(states, count, out);
+            double s[M];
+            for(size_t i=0; i<count; i++)
+            {
+                for(size_t d=0; d<M; d++)
+                    s[d] = states[d*count + i];
+                long id = this->get_cell(s);
+                out[i] = (id < 0) || (distance[id] <= robot_radius);
+            }
+            return 0;
+        }
+
+        double get_state_cost(const double s[N])
+        {
+            double c = get_distance(s);
+            if(c >= cost_distance)
+                return 0;
+            return cost_weight*(cost_distance - c)/cost_distance;
+        }
+
+    protected:
+        static void edt_1d(const double* f, size_t n, double* d, int* v, double* z)
+        {
+            int k = 0;
+            v[0] = 0;
+            z[0] = -DBL_MAX;
+            z[1] = DBL_MAX;
+            for(size_t q=1; q<n; q++)
+            {
+                double s = ((f[q] + (double)q*q) - (f[v[k]] + (double)v[k]*v[k]))/(2.0*q - 2.0*v[k]);
+                while(s <= z[k])
+                {
+                    k--;
+                    s = ((f[q] + (double)q*q) - (f[v[k]] + (double)v[k]*v[k]))/(2.0*q - 2.0*v[k]);
+                }
+                k++;
+                v[k] = q;
+                z[k] = s;
+                z[k+1] = DBL_MAX;
+            }
+            k = 0;
+            for(size_t q=0; q<n; q++)
+            {
+                while(z[k+1] < q)
+                    k++;
+                double t = (double)q - v[k];
+                d[q] = t*t + f[v[k]];
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,465 @@
+#ifndef __parallel_rrts_h__
+#define __parallel_rrts_h__
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <climits>
+#include "rrts.h"
+#include "thread_pool.h"
+using namespace std;
+
+/*
+ * RRT* with several worker threads growing one tree. Every worker runs the
+ * sample, near, best parent, insert and rewire loop on its own, vertices
+ * are published through a concurrent_kdtree_c without locks. Rewiring
+ * takes the locks of the new parent, the rewired vertex and its old parent
+ * (striped over a fixed table, always in the same order) and re-validates
+ * the costs it read before changing the tree.
+ *
+ * Costs only ever decrease, and a child's cost is never below its parent's
+ * cost plus the edge cost, so the re-validated cost check also rules out
+ * rewiring a vertex under one of its own descendants.
+ *
+ * Vertices and edges come from per-worker pools. An edge replaced by
+ * rewiring may belong to another worker's pool, it is kept until the next
+ * initialize(). Tree surgery (switch_root, check_tree, delete_downstream)
+ * and the serial iteration() are not available on this planner.
+ */
+template<class vertex_tt, class edge_tt>
+class parallel_rrts_c : public rrts_c<vertex_tt, edge_tt,
+    concurrent_kdtree_c<vertex_tt::system_t::N, vertex_tt*> >
+{
+    public:
+        typedef rrts_c<vertex_tt, edge_tt,
+                concurrent_kdtree_c<vertex_tt::system_t::N, vertex_tt*> > rrts_t;
+
+        typedef typename rrts_t::system_t system_t;
+        typedef typename rrts_t::state state;
+        typedef typename rrts_t::opt_data_t opt_data_t;
+        typedef typename rrts_t::trajectory_t trajectory_t;
+        typedef typename rrts_t::cost_t cost_t;
+        typedef typename rrts_t::vertex vertex;
+        typedef typename rrts_t::edge edge;
+        typedef typename rrts_t::parent_candidate_t parent_candidate_t;
+
+        const static size_t num_dim = rrts_t::num_dim;
+        const static size_t num_vertex_locks = 1024;
+
+        struct worker_t
+        {
+            pool_c<vertex> vertex_pool;
+            pool_c<edge> edge_pool;
+            random_c rng;
+            vector<vertex*> near_vertices;
+            vector<parent_candidate_t> candidates;
+            vector<size_t> order;
+            vector<pair<vertex*, cost_t> > branch_stack;
+            vector<vertex*> children_buffer;
+            int num_iterations;
+        };
+
+        int num_workers;
+        thread_pool_c* worker_pool;
+        vector<worker_t*> workers;
+
+        parallel_rrts_c(int num_workers_in=0)
+        {
+            worker_pool = NULL;
+            set_num_workers(num_workers_in);
+        }
+        parallel_rrts_c(plotter_c* plotter_in, int num_workers_in=0) : rrts_t(plotter_in)
+        {
+            worker_pool = NULL;
+            set_num_workers(num_workers_in);
+        }
+        ~parallel_rrts_c()
+        {
+            delete worker_pool;
+            for(auto& w : workers)
+                delete w;
+        }
+
+        // 0 uses all hardware threads. Workers are never removed because
+        // their pools hold part of the tree.
+        int set_num_workers(int num_workers_in)
+        {
+            if(num_workers_in <= 0)
+                num_workers_in = thread::hardware_concurrency();
+            if(num_workers_in <= 0)
+                num_workers_in = 1;
+            num_workers = num_workers_in;
+
+            delete worker_pool;
+            worker_pool = new thread_pool_c(num_workers);
+            while((int)workers.size() < num_workers)
+            {
+                workers.push_back(new worker_t());
+                workers.back()->rng = this->system.rng.fork();
+            }
+            return 0;
+        }
+
+        // every worker samples from its own stream forked off system.rng
+        int initialize(const state& rs, bool do_branch_and_bound_in=true)
+        {
+            for(auto& w : workers)
+            {
+                w->vertex_pool.clear();
+                w->edge_pool.clear();
+                w->rng = this->system.rng.fork();
+            }
+            return rrts_t::initialize(rs, do_branch_and_bound_in);
+        }
+
+        // runs num_iterations iterations spread over the workers
+        int iterate(int num_iterations)
+        {
+            return run(num_iterations, -1);
+        }
+
+        // runs iterations on all workers until time_ms have passed
+        int iterate_for(double time_ms)
+        {
+            return run(INT_MAX, time_ms);
+        }
+
+        int get_num_iterations() const
+        {
+            int n = 0;
+            for(auto& w : workers)
+                n += w->num_iterations;
+            return n;
+        }
+
+    protected:
+        mutex vertex_locks[num_vertex_locks];
+        mutex best_mutex;
+
+        int run(int num_iterations, double time_ms)
+        {
+            if(!this->root)
+                return 1;
+
+            for(auto& w : workers)
+                w->num_iterations = 0;
+            atomic<int> remaining(num_iterations);
+            tt clock;
+            clock.tic();
+            worker_pool->parallel_for(num_workers, [&](size_t i)
+            {
+                worker_t& w = *(workers[i]);
+                while(remaining.fetch_sub(1) > 0)
+                {
+                    if((time_ms > 0) && (clock.toc() > time_ms))
+                        break;
+                    worker_iteration(w);
+                    w.num_iterations++;
+                }
+            });
+
+            // rebuild the vertex list for the serial accessors and plotting
+            this->list_vertices.clear();
+            for(size_t i=0; i<this->kdtree.size(); i++)
+                this->list_vertices.push_back(this->kdtree.get_data(i));
+            this->num_vertices = this->list_vertices.size();
+            return 0;
+        }
+
+        static bool strictly_less(const cost_t& c1, const cost_t& c2)
+        {
+            return (c1 < c2) && !(c2 < c1);
+        }
+
+        mutex& vertex_lock(const vertex* v)
+        {
+            size_t h = (size_t)v;
+            return vertex_locks[((h >> 4) ^ (h >> 14)) & (num_vertex_locks-1)];
+        }
+
+        cost_t read_cost(vertex& v)
+        {
+            lock_guard<mutex> lock(vertex_lock(&v));
+            return v.cost_from_root;
+        }
+
+        // locks the distinct stripes of n vertices in address order
+        int lock_vertices(vertex* const* vs, size_t n, mutex** held)
+        {
+            int nh = 0;
+            for(size_t i=0; i<n; i++)
+            {
+                mutex* m = &vertex_lock(vs[i]);
+                if(find(held, held+nh, m) == held+nh)
+                    held[nh++] = m;
+            }
+            for(int i=1; i<nh; i++)
+            {
+                for(int j=i; (j > 0) && (held[j] < held[j-1]); j--)
+                    swap(held[j], held[j-1]);
+            }
+            for(int i=0; i<nh; i++)
+                held[i]->lock();
+            return nh;
+        }
+        void unlock_vertices(mutex** held, int nh)
+        {
+            for(int i=nh-1; i>=0; i--)
+                held[i]->unlock();
+        }
+
+        // in_goal is set before a vertex is published, workers only read it
+        int update_best_vertex_shared(vertex& v, const cost_t& cost)
+        {
+            if(!this->is_in_goal(v))
+                return 0;
+            lock_guard<mutex> lock(best_mutex);
+            if( (!this->lower_bound_vertex) || (cost < this->lower_bound_cost))
+            {
+                this->lower_bound_cost = cost;
+                this->lower_bound_vertex = &v;
+            }
+            return 0;
+        }
+
+        int get_near_vertices_shared(const state& s, vector<vertex*>& near_vertices)
+        {
+            double key[num_dim];
+            this->system.get_key(s, key);
+
+            double n = this->kdtree.size();
+            if(this->use_k_nearest)
+            {
+                size_t k = ceil(this->k_rrt*log(n + 1.0));
+                if(!this->kdtree.nearest_n(key, k, near_vertices))
+                    return 1;
+                return 0;
+            }
+
+            double rn = this->gamma*pow(log(n + 1.0)/(n + 1.0), 1.0/(double)num_dim);
+            if(!this->kdtree.near_range(key, rn, near_vertices))
+            {
+                vertex* vc = NULL;
+                if(this->kdtree.nearest(key, vc))
+                    return 1;
+                near_vertices.push_back(vc);
+            }
+            return 0;
+        }
+
+        parent_candidate_t* find_best_parent_shared(worker_t& w, const state& si)
+        {
+            vector<parent_candidate_t>& candidates = w.candidates;
+            candidates.resize(w.near_vertices.size());
+            w.order.clear();
+            for(size_t i=0; i<w.near_vertices.size(); i++)
+            {
+                parent_candidate_t& c = candidates[i];
+                c.v = w.near_vertices[i];
+                c.opt_data = opt_data_t();
+                c.res = this->system.evaluate_extend_cost(c.v->state, si, c.opt_data, c.edge_cost, c.dt);
+                if(c.res)
+                    continue;
+                c.cost = read_cost(*(c.v)) + c.edge_cost;
+                w.order.push_back(i);
+            }
+            stable_sort(w.order.begin(), w.order.end(), [&](size_t i1, size_t i2)
+            {
+                return strictly_less(candidates[i1].cost, candidates[i2].cost);
+            });
+
+            for(auto& i : w.order)
+            {
+                parent_candidate_t& c = candidates[i];
+                if(this->system.is_feasible(c.v->state, si, c.opt_data))
+                    return &c;
+            }
+            return NULL;
+        }
+
+        // moves vn under v if that is still cheaper once the locks are held
+        bool reparent_vertex(vertex& v, vertex& vn, edge& e, cost_t& vn_cost)
+        {
+            while(true)
+            {
+                vertex* old_parent;
+                {
+                    lock_guard<mutex> lock(vertex_lock(&vn));
+                    old_parent = vn.parent;
+                }
+                if(!old_parent)
+                    return false;
+
+                vertex* vs[3] = {&v, &vn, old_parent};
+                mutex* held[3];
+                int nh = lock_vertices(vs, 3, held);
+                if(vn.parent != old_parent)
+                {
+                    unlock_vertices(held, nh);
+                    continue;
+                }
+
+                cost_t cvn = v.cost_from_root + e.cost;
+                bool rewired = strictly_less(cvn, vn.cost_from_root);
+                if(rewired)
+                {
+                    old_parent->children.erase(&vn);
+                    vn.parent = &v;
+                    vn.edge_from_parent = &e;
+                    vn.cost_from_parent = e.cost;
+                    vn.cost_from_root = cvn;
+                    vn.t0 = v.t0 + e.dt;
+                    v.children.insert(&vn);
+                    vn_cost = cvn;
+                }
+                unlock_vertices(held, nh);
+                return rewired;
+            }
+        }
+
+        // costs only decrease, the walk stops at vertices that do not improve
+        int update_branch_cost_shared(worker_t& w, vertex& v, const cost_t& v_cost)
+        {
+            w.branch_stack.clear();
+            w.branch_stack.push_back(make_pair(&v, v_cost));
+            while(!w.branch_stack.empty())
+            {
+                vertex* pv = w.branch_stack.back().first;
+                cost_t pv_cost = w.branch_stack.back().second;
+                w.branch_stack.pop_back();
+
+                w.children_buffer.clear();
+                {
+                    lock_guard<mutex> lock(vertex_lock(pv));
+                    w.children_buffer.insert(w.children_buffer.end(),
+                            pv->children.begin(), pv->children.end());
+                }
+                for(auto& pc : w.children_buffer)
+                {
+                    bool improved = false;
+                    cost_t c_cost;
+                    {
+                        lock_guard<mutex> lock(vertex_lock(pc));
+                        if(pc->parent != pv)
+                            continue;
+                        c_cost = pv_cost + pc->cost_from_parent;
+                        if(strictly_less(c_cost, pc->cost_from_root))
+                        {
+                            pc->cost_from_root = c_cost;
+                            improved = true;
+                        }
+                    }
+                    if(improved)
+                    {
+                        update_best_vertex_shared(*pc, c_cost);
+                        w.branch_stack.push_back(make_pair(pc, c_cost));
+                    }
+                }
+            }
+            return 0;
+        }
+
+        int rewire_vertices_shared(worker_t& w, vertex& v, const cost_t& v_cost)
+        {
+            for(auto& pvn : w.near_vertices)
+            {
+                vertex& vn = *pvn;
+                opt_data_t opt_data;
+                cost_t cost_edge;
+                double en_dt;
+                if(this->system.evaluate_extend_cost(v.state, vn.state, opt_data, cost_edge, en_dt))
+                    continue;
+                if(!strictly_less(v_cost + cost_edge, read_cost(vn)))
+                    continue;
+
+                if(!this->system.is_feasible(v.state, vn.state, opt_data))
+                    continue;
+
+                edge* en = w.edge_pool.construct(&(v.state), &(vn.state), cost_edge, en_dt, opt_data);
+                en->is_checked = true;
+                cost_t vn_cost;
+                if(!reparent_vertex(v, vn, *en, vn_cost))
+                {
+                    w.edge_pool.destroy(en);
+                    continue;
+                }
+                update_best_vertex_shared(vn, vn_cost);
+                update_branch_cost_shared(w, vn, vn_cost);
+            }
+            return 0;
+        }
+
+        int worker_iteration(worker_t& w)
+        {
+            system_t& system = this->system;
+
+            // 1. sample
+            state sr;
+            int ret = 0;
+            if(w.rng.uniform() < this->goal_sample_freq)
+                ret = system.sample_in_goal(sr, w.rng);
+            else
+                ret = system.sample_state(sr, w.rng);
+            if(ret)
+                return 1;
+
+            // 2. near vertices
+            w.near_vertices.clear();
+            if(get_near_vertices_shared(sr, w.near_vertices))
+                return 2;
+
+            // 3. best parent
+            parent_candidate_t* best = find_best_parent_shared(w, sr);
+            if(!best)
+                return 3;
+            vertex& parent = *(best->v);
+
+            // 4. branch and bound
+            if(this->do_branch_and_bound)
+            {
+                lock_guard<mutex> lock(best_mutex);
+                if(best->cost > this->lower_bound_cost)
+                    return 4;
+            }
+
+            // 5. link the new vertex under its parent, then publish it
+            vertex* nv = w.vertex_pool.construct(sr);
+            nv->in_goal = system.is_in_goal(nv->state);
+            double dt = best->dt;
+            edge* e = w.edge_pool.construct(&(parent.state), &(nv->state), best->edge_cost, dt, best->opt_data);
+            e->is_checked = true;
+            nv->edge_from_parent = e;
+            nv->parent = &parent;
+            nv->cost_from_parent = e->cost;
+            cost_t nv_cost;
+            {
+                lock_guard<mutex> lock(vertex_lock(&parent));
+                nv->t0 = parent.t0 + dt;
+                nv->cost_from_root = parent.cost_from_root + e->cost;
+                nv_cost = nv->cost_from_root;
+                parent.children.insert(nv);
+            }
+            update_best_vertex_shared(*nv, nv_cost);
+
+            double key[num_dim];
+            system.get_key(nv->state, key);
+            if(this->kdtree.insert(key, nv))
+                return 5;
+
+            // 6. rewire
+            rewire_vertices_shared(w, *nv, nv_cost);
+            return 0;
+        }
+
+    private:
+        using rrts_t::iteration;
+        using rrts_t::switch_root;
+        using rrts_t::check_tree;
+        using rrts_t::lazy_check_tree;
+        using rrts_t::delete_downstream;
+
+        parallel_rrts_c(const parallel_rrts_c&);
+        parallel_rrts_c& operator=(const parallel_rrts_c&);
+};
+
+#endif
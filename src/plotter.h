@@ -0,0 +1,112 @@
+#ifndef __plotter_h__
+#define __plotter_h__
+
+#include <vector>
+using namespace std;
+
+/*
+ * Planners do not draw. plot_tree, plot_best_trajectory and plot_environment
+ * copy what they would draw into a plot_snapshot_c, in the coordinates of
+ * system.get_plotter_state, and hand it to a plotter_c if one is set.
+ * lcmgl_plotter.h draws snapshots with libbot, other front ends only have
+ * to implement draw().
+ */
+struct plot_points_t
+{
+    double color[4];
+    double size;
+    // 3 doubles per point
+    vector<double> xyz;
+};
+
+struct plot_lines_t
+{
+    double color[4];
+    double width;
+    // 6 doubles per segment
+    vector<double> xyz;
+};
+
+struct plot_box_t
+{
+    double color[4];
+    double c[3];
+    double s[3];
+};
+
+class plot_snapshot_c
+{
+    public:
+        vector<plot_points_t> points;
+        vector<plot_lines_t> lines;
+        vector<plot_box_t> boxes;
+
+        void clear()
+        {
+            points.clear();
+            lines.clear();
+            boxes.clear();
+        }
+        bool empty() const
+        {
+            return points.empty() && lines.empty() && boxes.empty();
+        }
+
+        plot_points_t& add_points(const double* color, double size)
+        {
+            points.push_back(plot_points_t());
+            plot_points_t& p = points.back();
+            for(int i=0; i<4; i++)
+                p.color[i] = color[i];
+            p.size = size;
+            return p;
+        }
+        plot_lines_t& add_lines(const double* color, double width)
+        {
+            lines.push_back(plot_lines_t());
+            plot_lines_t& l = lines.back();
+            for(int i=0; i<4; i++)
+                l.color[i] = color[i];
+            l.width = width;
+            return l;
+        }
+
+        // the segments between consecutive states of traj
+        template<class system_t, class trajectory_t>
+        static void add_trajectory(system_t& system, const trajectory_t& traj, plot_lines_t& l)
+        {
+            double s1[3] = {0}, s2[3] = {0};
+            for(size_t i=0; i+1<traj.states.size(); i++)
+            {
+                if(i == 0)
+                    system.get_plotter_state(traj.states[i], s1);
+                system.get_plotter_state(traj.states[i+1], s2);
+                l.xyz.insert(l.xyz.end(), s1, s1+3);
+                l.xyz.insert(l.xyz.end(), s2, s2+3);
+                for(int k=0; k<3; k++)
+                    s1[k] = s2[k];
+            }
+        }
+
+        template<class region_t>
+        void add_region(region_t& r, int dim=3)
+        {
+            boxes.push_back(plot_box_t());
+            plot_box_t& b = boxes.back();
+            for(int i=0; i<3; i++)
+                b.c[i] = b.s[i] = 0;
+            r.get_plotter_state(b.c, b.s, dim);
+            for(int i=0; i<4; i++)
+                b.color[i] = r.color[i];
+        }
+};
+
+class plotter_c
+{
+    public:
+        virtual ~plotter_c(){}
+        // called once per plot_* call of the planner
+        virtual void draw(const plot_snapshot_c& snapshot) = 0;
+};
+
+#endif
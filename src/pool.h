@@ -0,0 +1,143 @@
+#ifndef __pool_h__
+#define __pool_h__
+
+#include <vector>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+using namespace std;
+
+/*
+ * Slab allocator for objects of a single type. Objects are handed out from
+ * contiguous blocks of block_size slots, freed slots are recycled through a
+ * free list, and clear() returns every slot while keeping the blocks for the
+ * next run. Not thread-safe.
+ */
+template<class T>
+class pool_c
+{
+    public:
+        typedef T value_t;
+
+        pool_c(size_t block_size_in=1024)
+        {
+            block_size = block_size_in ? block_size_in : 1;
+            free_slots = NULL;
+            current_block = 0;
+            current_index = 0;
+            num_live = 0;
+        }
+        ~pool_c()
+        {
+            clear();
+            for(auto& b : blocks)
+                delete[] b;
+        }
+
+        template<class... args_t>
+        T* construct(args_t&&... args)
+        {
+            slot_t* s = get_slot();
+            T* p = new (&(s->storage)) T(std::forward<args_t>(args)...);
+            s->live = true;
+            num_live++;
+            return p;
+        }
+
+        void destroy(T* p)
+        {
+            if(!p)
+                return;
+            slot_t* s = reinterpret_cast<slot_t*>(p);
+            p->~T();
+            s->live = false;
+            s->next = free_slots;
+            free_slots = s;
+            num_live--;
+        }
+
+        // destroys all live objects, the blocks are kept and reused. O(1)
+        // for trivially destructible T, otherwise it walks the used slots up
+        // to the last live one and runs each destructor. vertex_c is not
+        // trivially destructible, its std::set of children still frees one
+        // heap node per child here.
+        void clear()
+        {
+            if(!is_trivially_destructible<T>::value)
+            {
+                size_t left = num_live;
+                for(size_t b=0; left && b<=current_block && b<blocks.size(); b++)
+                {
+                    size_t n = (b == current_block) ? current_index : block_size;
+                    for(size_t i=0; left && i<n; i++)
+                    {
+                        slot_t& s = blocks[b][i];
+                        if(s.live)
+                        {
+                            reinterpret_cast<T*>(&(s.storage))->~T();
+                            s.live = false;
+                            left--;
+                        }
+                    }
+                }
+            }
+            free_slots = NULL;
+            current_block = 0;
+            current_index = 0;
+            num_live = 0;
+        }
+
+        size_t size() const
+        {
+            return num_live;
+        }
+        size_t capacity() const
+        {
+            return blocks.size()*block_size;
+        }
+
+    private:
+        // storage comes first so that a T* is also a slot_t*
+        struct slot_t
+        {
+            typename aligned_storage<sizeof(T), alignof(T)>::type storage;
+            slot_t* next;
+            bool live;
+        };
+
+        size_t block_size;
+        vector<slot_t*> blocks;
+        slot_t* free_slots;
+        size_t current_block;
+        size_t current_index;
+        size_t num_live;
+
+        slot_t* get_slot()
+        {
+            if(free_slots)
+            {
+                slot_t* s = free_slots;
+                free_slots = s->next;
+                return s;
+            }
+            if(current_index == block_size)
+            {
+                current_block++;
+                current_index = 0;
+            }
+            if(current_block == blocks.size())
+            {
+                slot_t* b = new slot_t[block_size];
+                for(size_t i=0; i<block_size; i++)
+                    b[i].live = false;
+                blocks.push_back(b);
+            }
+            return &(blocks[current_block][current_index++]);
+        }
+
+        pool_c(const pool_c&);
+        pool_c& operator=(const pool_c&);
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef __random_h__
+#define __random_h__
+
+#include <cstddef>
+#include <cmath>
+#include <stdint.h>
+using namespace std;
+
+/*
+ * xoshiro256** generator (Blackman and Vigna). The 256-bit state is seeded
+ * from a single 64-bit value through splitmix64, so equal seeds give
+ * bit-identical streams on every platform. fork() hands out a stream that
+ * is 2^128 draws away from the remaining one, use it to give every thread
+ * its own generator. Not thread-safe, each thread needs its own copy.
+ */
+class random_c
+{
+    public:
+        random_c(uint64_t seed_in=0)
+        {
+            seed(seed_in);
+        }
+
+        void seed(uint64_t seed_in)
+        {
+            uint64_t x = seed_in;
+            for(int i=0; i<4; i++)
+                s[i] = splitmix64(x);
+        }
+
+        uint64_t next()
+        {
+            const uint64_t result = rotl(s[1]*5, 7)*9;
+            const uint64_t t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+        // uniform in [0, 1) with 53 random bits
+        double uniform()
+        {
+            return (next() >> 11)*(1.0/9007199254740992.0);
+        }
+        double uniform(double a, double b)
+        {
+            return a + (b-a)*uniform();
+        }
+        // fills out[0..n) with uniforms in [0, 1)
+        void uniform(double* out, size_t n)
+        {
+            for(size_t i=0; i<n; i++)
+                out[i] = (next() >> 11)*(1.0/9007199254740992.0);
+        }
+        // uniform in {0, .., n-1}
+        size_t uniform_int(size_t n)
+        {
+            return (size_t)(uniform()*n);
+        }
+        // standard normal, Marsaglia's polar method
+        double normal()
+        {
+            double u, v, r;
+            do
+            {
+                u = 2*uniform() - 1;
+                v = 2*uniform() - 1;
+                r = u*u + v*v;
+            } while((r >= 1) || (r == 0));
+            return u*sqrt(-2*log(r)/r);
+        }
+
+        // advances the stream by 2^128 draws
+        void jump()
+        {
+            static const uint64_t jump_poly[4] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+            uint64_t t[4] = {0, 0, 0, 0};
+            for(int i=0; i<4; i++)
+            {
+                for(int b=0; b<64; b++)
+                {
+                    if(jump_poly[i] & (1ULL << b))
+                    {
+                        for(int j=0; j<4; j++)
+                            t[j] ^= s[j];
+                    }
+                    next();
+                }
+            }
+            for(int j=0; j<4; j++)
+                s[j] = t[j];
+        }
+
+        // returns a generator on the current stream and moves this one
+        // to the next non-overlapping stream
+        random_c fork()
+        {
+            random_c r = *this;
+            jump();
+            return r;
+        }
+
+    protected:
+        uint64_t s[4];
+
+        static uint64_t rotl(const uint64_t x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+        static uint64_t splitmix64(uint64_t& x)
+        {
+            uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+};
+
+#endif
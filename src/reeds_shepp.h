@@ -68,10 +68,11 @@ class reeds_shepp_c : public dynamical_system_c<state_c<3>, control_c<4>, reeds_
             return 0;
         }
 
-        int sample_state(double* center, double* size, double* s)
+        int sample_state(double* center, double* size, double* s, random_c& rng)
         {
+            rng.uniform(s, 3);
             for(int i : range(0,3))
-                s[i] = center[i] + (RANDF-0.5)*size[i];
+                s[i] = center[i] + (s[i]-0.5)*size[i];
             return 0;
         }
 
@@ -105,6 +106,36 @@ class reeds_shepp_c : public dynamical_system_c<state_c<3>, control_c<4>, reeds_
             return 0;
         }
 
+        // constRS writes into per-thread buffers instead of a trajectory
+        int steer(const state_t& si, const state_t& sf, reeds_shepp_optimization_data_t& opt_data,
+                size_t stride, const state_block_callback_t& cb)
+        {
+            if(opt_data._turning_radius < 0)
+            {
+                evaluate_extend_cost(si, sf, opt_data);
+            }
+            const int N = 10000;
+            static thread_local vector<double> px(N), py(N), pth(N);
+            int traj_len = constRS(opt_data._numero, opt_data._t, opt_data._u, opt_data._v,
+                    si[0], si[1], si[2],
+                    delta_distance,
+                    &px[0], &py[0], &pth[0]);
+
+            state_block_writer_c<3> writer(cb);
+            for(int i=0; i<traj_len; i+=stride)
+            {
+                double s[3] = {px[i], py[i], pth[i]};
+                if(int res = writer.push(s))
+                    return res;
+            }
+            return writer.flush();
+        }
+
+        size_t get_euclidean_bound_dim()
+        {
+            return 2;
+        }
+
         double evaluate_extend_cost(const state_t& si, const state_t& sf,
                 reeds_shepp_optimization_data_t& opt_data)
         {
@@ -141,7 +172,7 @@ class reeds_shepp_c : public dynamical_system_c<state_c<3>, control_c<4>, reeds_
             state_t origin(zero);
             double goal[3] = {0,0, 175/180.0*M_PI};
             state_t sr(goal);
-            sr.print(cout, "sampled:","\n");
+            print_state(sr, cout, "sampled:", "\n");
 
             reeds_shepp_optimization_data_c opt_data;
             extend_to(origin, sr, traj, opt_data);
@@ -7,19 +7,21 @@
 #include <set>
 #include <queue>
 #include <cfloat>
-#include "kdtree.h"
+#include "kd_tree.h"
+#include "pool.h"
+#include "thread_pool.h"
 #include <algorithm>
 #include <tuple>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "system.h"
 #include "utils.h"
 
-#include <lcm/lcm.h>
-#include <bot_core/bot_core.h>
-#include <bot_lcmgl_client/lcmgl.h>
-#include <bot_vis/gl_util.h>
+#include "plotter.h"
+#include "stats.h"
+#include "anytime.h"
 
 using namespace std;
 
@@ -46,6 +48,8 @@ class vertex_c
         set<vertex*> children;
 
         int mark;
+        // 1 if the state is in the goal region, -1 until it is checked
+        int in_goal;
 
         cost_t cost_from_root;
         cost_t cost_from_parent;
@@ -56,19 +60,16 @@ class vertex_c
             parent = NULL;
             edge_from_parent = NULL;
             mark = 0;
+            in_goal = -1;
             t0 = 0;
         }
-        ~vertex_c()
-        {
-            if(edge_from_parent)
-                delete edge_from_parent;
-        }
         vertex_c(const state_t& si)
         {
             parent = NULL;
             edge_from_parent = NULL;
             state = si;
             mark = 0;
+            in_goal = -1;
             t0 =0;
         }
 
@@ -106,12 +107,19 @@ class edge_c
         cost_t cost;
         opt_data_t opt_data;
         double dt;
+        // set once the edge has been collision checked
+        bool is_checked;
+        // steered trajectory, kept by rrts_c::get_edge_trajectory() and
+        // freed with the edge, i.e., when its vertex is deleted or rewired
+        trajectory* traj;
 
         edge_c()
         {
             end_state = NULL;
             start_state = NULL;
             dt = 0;
+            is_checked = false;
+            traj = NULL;
         };
 
         edge_c(const state* si, const state* se, cost_t& c, double dt_in, opt_data_t& opt_data_in)
@@ -121,10 +129,21 @@ class edge_c
             opt_data = opt_data_in;
             cost = c;
             dt = dt_in;
+            is_checked = false;
+            traj = NULL;
+        }
+        ~edge_c()
+        {
+            delete traj;
         }
+
+    private:
+        edge_c(const edge_c&);
+        edge_c& operator=(const edge_c&);
 };
 
-template<class vertex_tt, class edge_tt>
+template<class vertex_tt, class edge_tt,
+    class kdtree_tt = kdtree_c<vertex_tt::system_t::N, vertex_tt*> >
 class rrts_c
 {
     public:
@@ -142,8 +161,7 @@ class rrts_c
         typedef vertex_tt vertex;
         typedef edge_tt edge;
 
-        typedef struct kdtree kdtree_t;
-        typedef struct kdres kdres_t;
+        typedef kdtree_tt kdtree_t;
 
         system_t system;
 
@@ -154,14 +172,98 @@ class rrts_c
         double goal_sample_freq;
         bool do_branch_and_bound;
 
+        // k-nearest RRT*: connect to the k = k_rrt*log(n) nearest vertices
+        // instead of those within gamma*(log(n)/n)^(1/d)
+        bool use_k_nearest;
+        double k_rrt;
+
+        // lazy RRT*: edges enter the tree without a collision check. The
+        // path to lower_bound_vertex is checked when it is requested or
+        // when an iteration lowers the best cost below checked_cost. The
+        // subtree below a colliding edge is attached again without that
+        // edge, see repair_subtree(). Until then get_best_cost() is only
+        // a lower bound.
+        bool lazy_collision_checking;
+
+        // keep the trajectories of the edges on the paths extracted by
+        // get_trajectory_root, switch_root and plot_tree only read them
+        bool cache_trajectories;
+
         vertex* root;
         cost_t lower_bound_cost;
+        // lazy mode: cost of the last path check_best_path() found feasible,
+        // branch and bound and informed sampling use it instead of
+        // lower_bound_cost
+        cost_t checked_cost;
+        // lazy mode: (parent, child) pairs whose edge collides, forgotten
+        // when vertices are freed
+        struct vertex_pair_hash_t
+        {
+            size_t operator()(const pair<vertex*, vertex*>& p) const
+            {
+                return hash<vertex*>()(p.first)*31 + hash<vertex*>()(p.second);
+            }
+        };
+        unordered_set<pair<vertex*, vertex*>, vertex_pair_hash_t> rejected_edges;
         vertex* lower_bound_vertex;
-        kdtree_t* kdtree;
+        kdtree_t kdtree;
+        pool_c<vertex> vertex_pool;
+        pool_c<edge> edge_pool;
+        vector<vertex*> near_vertices_buffer;
+        vector<vertex*> branch_stack;
         vertex* last_added_vertex;
+        // if set, remove_vertices appends every vertex it frees, birrts_c
+        // uses it to drop the bridges that ended at one
+        vector<vertex*>* removed_vertices;
+
+        // see stats.h, only updated with SMPL_STATS
+        rrts_stats_t stats;
+        vector<size_t> branch_depth_stack;
+
+        // deadline and early stop of plan_until
+        plan_budget_c budget;
+
+        // parallel find_best_parent, see set_num_threads()
+        struct parent_candidate_t
+        {
+            vertex* v;
+            cost_t edge_cost;
+            cost_t cost;
+            opt_data_t opt_data;
+            double dt;
+            int res;
+        };
+        thread_pool_c* thread_pool;
+        size_t num_speculative_checks;
+
+        // lazy mode, edges into a subtree that is attached again, see
+        // repair_subtree()
+        struct repair_edge_t
+        {
+            cost_t cost, edge_cost;
+            vertex* v;
+            vertex* parent;
+            opt_data_t opt_data;
+            double dt;
+        };
+        // the heap keeps the cheapest edge on top
+        struct repair_heap_compare_t
+        {
+            const vector<repair_edge_t>& edges;
+            repair_heap_compare_t(const vector<repair_edge_t>& edges_in) : edges(edges_in) {}
+            bool operator()(size_t i1, size_t i2) const
+            {
+                return strictly_less(edges[i2].cost, edges[i1].cost);
+            }
+        };
+        vector<repair_edge_t> repair_edges;
+        vector<size_t> repair_heap;
+        vector<parent_candidate_t> parent_candidates;
+        vector<size_t> parent_order;
 
         static int debug_counter;
-        bot_lcmgl_t* lcmgl;
+        // draws the snapshots of the plot_* calls, may be NULL
+        plotter_c* plotter;
         double points_color[4];
         double points_size;
         double lines_color[4];
@@ -170,6 +272,8 @@ class rrts_c
         double best_lines_width;
 
         rrts_c(){
+            plotter = NULL;
+            thread_pool = NULL;
             basic_initialization();
         }
 
@@ -199,13 +303,18 @@ class rrts_c
             gamma = 2.5;
             goal_sample_freq = 0.1;
             do_branch_and_bound = true;
+            use_k_nearest = false;
+            lazy_collision_checking = false;
+            cache_trajectories = true;
+            k_rrt = 1.1*(M_E + M_E/(double)num_dim);
 
             root = NULL;
             lower_bound_vertex = NULL;
             last_added_vertex = NULL;
+            removed_vertices = NULL;
 
-            kdtree = NULL;
             num_vertices = 0;
+            num_speculative_checks = 0;
 
             double pc[4] = {1,1,0,0.9};
             double lc[4] = {1,1,1,0.5};
@@ -215,28 +324,80 @@ class rrts_c
             set_best_lines_color(blc, 4);
         }
 
-        rrts_c(bot_lcmgl_t* lcmgl_in){
-            lcmgl = lcmgl_in;
+        rrts_c(plotter_c* plotter_in){
+            plotter = plotter_in;
+            thread_pool = NULL;
             basic_initialization();
         }
 
         ~rrts_c()
         {
-            if(kdtree)
-                kd_free(kdtree);
             clear_list_vertices();
+            delete thread_pool;
+        }
+
+        // a copy, the counters keep running until reset_stats()
+        rrts_stats_t get_stats() const {return stats;}
+        void reset_stats() {stats.reset();}
+
+        // runs iterations until the deadline and cuts the last one short,
+        // or stops earlier as set in budget (anytime.h). Afterwards
+        // best_traj is the best trajectory, returns 1 if there is none.
+        int plan_until(const plan_clock_t::time_point& deadline, trajectory_t& best_traj,
+                plan_stats_t* plan_stats=NULL)
+        {
+            budget.start(deadline, lower_bound_cost.val[0], lower_bound_vertex != NULL);
+            bool done = (plan_clock_t::now() >= deadline);
+            while(!done)
+            {
+                int res = iteration();
+                done = budget.add_iteration(res, lower_bound_cost.val[0], lower_bound_vertex != NULL);
+            }
+            const plan_stats_t& s = budget.stop();
+            if(plan_stats)
+                *plan_stats = s;
+            return get_best_trajectory(best_traj);
+        }
+        template<class rep_t, class period_t>
+        int plan_for(const chrono::duration<rep_t, period_t>& duration, trajectory_t& best_traj,
+                plan_stats_t* plan_stats=NULL)
+        {
+            return plan_until(plan_clock_t::now() + chrono::duration_cast<plan_clock_t::duration>(duration),
+                    best_traj, plan_stats);
+        }
+
+        // evaluate steering costs and collision checks of find_best_parent
+        // on num_threads threads. The map and the dynamical system must
+        // allow concurrent calls to is_in_collision, extend_to and
+        // evaluate_extend_cost. num_threads <= 1 goes back to the serial
+        // loop, 0 collision checks per round means one per thread.
+        int set_num_threads(int num_threads, size_t num_speculative_checks_in=0)
+        {
+            delete thread_pool;
+            thread_pool = NULL;
+            if(num_threads > 1)
+                thread_pool = new thread_pool_c(num_threads);
+            num_speculative_checks = num_speculative_checks_in;
+            return 0;
         }
 
         void clear_list_vertices()
         {
-            for(auto& i : list_vertices)
-                delete i;
+            vertex_pool.clear();
+            edge_pool.clear();
             list_vertices.clear();
             num_vertices = 0;
         }
+
+        void free_vertex(vertex* v)
+        {
+            if(v->edge_from_parent)
+                edge_pool.destroy(v->edge_from_parent);
+            vertex_pool.destroy(v);
+        }
         int set_root(const state& rs)
         {
-            root = new vertex(rs);
+            root = vertex_pool.construct(rs);
             root->cost_from_root = system.get_zero_cost();
             root->cost_from_parent = system.get_zero_cost();
             root->edge_from_parent = NULL;
@@ -252,14 +413,15 @@ class rrts_c
             clear_list_vertices();  
             lower_bound_cost = system.get_inf_cost();
             lower_bound_vertex = NULL;
+            checked_cost = system.get_inf_cost();
+            rejected_edges.clear();
+            system.set_informed_cost(rs, lower_bound_cost.val.back());
             do_branch_and_bound = do_branch_and_bound_in;
 
-            if(kdtree)
-                kd_free(kdtree);
-            kdtree = kd_create(num_dim);
+            kdtree.clear();
 
             set_root(rs);
-            root->state.print(cout,"set root to:", "\n");
+            print_state(root->state, cout, "set root to:", "\n");
             last_added_vertex = root;
 
             return 0;
@@ -299,17 +461,23 @@ class rrts_c
         int iteration(state* s_in = NULL, set<vertex*>* rewired_vertices=NULL, trajectory_t* obstacle_trajectory=NULL, double collision_distance = 1)
         {
             last_added_vertex = NULL;
+            SMPL_STAT(stats_timer_c iteration_timer(stats.iteration_time));
+            SMPL_STAT(stats.iterations++);
 
             // 1. sample
             state sr;
             if(!s_in)
             {
+                SMPL_STAT(stats_timer_c sample_timer(stats.sample_time));
+                SMPL_STAT(stats.samples++);
+                SMPL_STAT(size_t num_rejected = system.num_rejected_samples());
                 int ret = 0;
-                double p = RANDF;
+                double p = system.rng.uniform();
                 if(p < goal_sample_freq)
                     ret = system.sample_in_goal(sr);
                 else
                     ret = system.sample_state(sr);
+                SMPL_STAT(stats.rejected_samples += system.num_rejected_samples() - num_rejected);
                 if(ret)
                     return 1;
             }
@@ -317,15 +485,24 @@ class rrts_c
                 sr = *s_in;
 
             // 2. compute nearest vertices
-            vector<vertex*> near_vertices;
+            vector<vertex*>& near_vertices = near_vertices_buffer;
+            near_vertices.clear();
             if(get_near_vertices(sr, near_vertices))
                 return 2;
+            SMPL_STAT(stats.add_near_query(near_vertices.size()));
+            if(budget.past_deadline())
+                return plan_budget_c::interrupted;
 
             // 3. best parent
             vertex* best_parent = NULL;
             edge* edge_from_parent = NULL;
             if(find_best_parent(sr, near_vertices, best_parent, edge_from_parent))
-                return 3;
+                return budget.past_deadline() ? plan_budget_c::interrupted : 3;
+            if(budget.past_deadline())
+            {
+                edge_pool.destroy(edge_from_parent);
+                return plan_budget_c::interrupted;
+            }
 
             // 4.a check if the trajectory new sample collides with collision_trajectory
             if(obstacle_trajectory)
@@ -336,28 +513,39 @@ class rrts_c
                 tmp_traj.t0 = best_parent->t0;
 
                 if(check_collision_trajectory(*obstacle_trajectory, tmp_traj, collision_distance))
+                {
+                    edge_pool.destroy(edge_from_parent);
                     return 4;
+                }
             }
 
             // 4. draw edge to parent from new vertex
             vertex* new_vertex = insert_edge(*best_parent, *edge_from_parent);
             if(!new_vertex)
+            {
+                edge_pool.destroy(edge_from_parent);
                 return 5;
+            }
 
             // 5. rewire
             if(near_vertices.size())
                 rewire_vertices(*new_vertex, near_vertices, rewired_vertices);
 
             last_added_vertex = new_vertex;
+            SMPL_STAT(stats.added_vertices++);
+
+            // 6. lazy: collision check a path that beats the checked one,
+            // this may free new_vertex and reset last_added_vertex
+            if(lazy_collision_checking && lower_bound_vertex && strictly_less(lower_bound_cost, checked_cost))
+                check_best_path();
             return 0;
         }
 
         int insert_into_kdtree(vertex& v)
         {
-            double* key = new double[num_dim];
+            double key[num_dim];
             system.get_key(v.state, key);
-            kd_insert(kdtree, key, &v);
-            delete[] key;
+            kdtree.insert(key, &v);
 
             list_vertices.push_back(&v);
             num_vertices++;
@@ -368,31 +556,54 @@ class rrts_c
         cost_t get_best_cost()    {return lower_bound_cost;};
         vertex& get_best_vertex() {return *lower_bound_vertex;}
 
-        int get_trajectory_root(vertex& v, trajectory_t& root_traj)
+        // the trajectory from v's parent to v, steered on the first call
+        // and kept on the edge if store is set. Points to buffer otherwise.
+        int get_edge_trajectory(vertex& v, const trajectory_t*& traj,
+                trajectory_t& buffer, bool store)
         {
-            root_traj.clear();
-
+            edge& e = *(v.edge_from_parent);
+            if(e.traj)
+            {
+                traj = e.traj;
+                return 0;
+            }
             bool check_obstacles = false;
-            vertex* vc = static_cast<vertex*>(&v);
-            while(vc)
+            if(!store)
             {
-                vertex* vparent = static_cast<vertex*>(vc->parent);
-                if(vparent)
-                {
-                    trajectory_t traj_from_parent;
-                    system.extend_to(vparent->state, vc->state, check_obstacles,
-                            traj_from_parent, vc->edge_from_parent->opt_data);
-                    traj_from_parent.reverse();
-                    root_traj.append(traj_from_parent);
-                }
-                vc = vparent;
+                traj = &buffer;
+                return system.extend_to(v.parent->state, v.state, check_obstacles,
+                        buffer, e.opt_data);
             }
+            trajectory_t* t = new trajectory_t();
+            if(system.extend_to(v.parent->state, v.state, check_obstacles, *t, e.opt_data))
+            {
+                delete t;
+                return 1;
+            }
+            e.traj = t;
+            traj = t;
+            return 0;
+        }
+
+        int get_trajectory_root(vertex& v, trajectory_t& root_traj)
+        {
+            root_traj.clear();
+
+            list<vertex*> path;
+            for(vertex* vc = &v; vc->parent; vc = vc->parent)
+                path.push_front(vc);
 
             root_traj.states.push_back(root->state);
-            double first_control = 0;
-            root_traj.controls.push_back(control(&first_control));
+            root_traj.controls.push_back(control());
 
-            root_traj.reverse();
+            trajectory_t buffer;
+            for(auto& pv : path)
+            {
+                const trajectory_t* traj_from_parent;
+                if(get_edge_trajectory(*pv, traj_from_parent, buffer, cache_trajectories))
+                    continue;
+                root_traj.append(*traj_from_parent);
+            }
             root_traj.t0 = 0;
             root_traj.dt = 0.05;
             return 0;
@@ -400,6 +611,8 @@ class rrts_c
 
         int get_best_trajectory(trajectory_t& best_traj)
         {
+            if(lazy_collision_checking)
+                check_best_path();
             if(!lower_bound_vertex)
                 return 1;
 
@@ -409,70 +622,58 @@ class rrts_c
 
         int get_nearest_vertex(const state& s, vertex*& nearest_vertex)
         {
-            int toret = 0;
-            double* key = new double[num_dim];
+            double key[num_dim];
             system.get_key(s, key);
-
-            double rn = gamma*pow(log(num_vertices + 1.0)/(num_vertices+1.0), 1.0/(double)num_dim);
-            kdres_t* kdres = kd_nearest(kdtree, key);
-            if(!kd_res_size(kdres))
-                toret = 1;
-            else
-                nearest_vertex = (vertex*) kd_res_item_data(kdres);
-
-            delete[] key;
-            kd_res_free(kdres);
-            return toret;
+            return kdtree.nearest(key, nearest_vertex);
         }
 
         int get_near_vertices(const state& s, vector<vertex*>& near_vertices)
         {
-            int toret = 0;
-            double* key = new double[num_dim];
+            SMPL_STAT(stats_timer_c timer(stats.near_time));
+            double key[num_dim];
             system.get_key(s, key);
 
-            double rn = gamma*pow(log(num_vertices + 1.0)/(num_vertices+1.0), 1.0/(double)num_dim);
-            kdres_t* kdres = kd_nearest_range(kdtree, key, rn);
-
-            int num_near_vertices = kd_res_size(kdres);
-            if(!num_near_vertices)
+            if(use_k_nearest)
             {
-                kd_res_free(kdres);
-
-                // get nearest vertex
-                kdres = kd_nearest(kdtree, key);
-                if(kd_res_end(kdres))
-                    toret = 1;
-                else
-                {
-                    vertex* vc = (vertex*) kd_res_item_data(kdres);
-                    near_vertices.push_back(vc);
-                }
+                size_t k = ceil(k_rrt*log(num_vertices + 1.0));
+                if(!kdtree.nearest_n(key, k, near_vertices))
+                    return 1;
+                return 0;
             }
-            else
+
+            double rn = gamma*pow(system.get_informed_volume_fraction()*log(num_vertices + 1.0)/(num_vertices+1.0),
+                    1.0/(double)num_dim);
+            if(!kdtree.near_range(key, rn, near_vertices))
             {
-                while(! kd_res_end(kdres))
-                {
-                    vertex* vc = (vertex*)kd_res_item_data(kdres);
-                    near_vertices.push_back(vc);
-                    kd_res_next(kdres);
-                }
+                // get nearest vertex
+                vertex* vc = NULL;
+                if(kdtree.nearest(key, vc))
+                    return 1;
+                near_vertices.push_back(vc);
             }
+            return 0;
+        }
 
-            delete[] key;
-            kd_res_free(kdres);
-            return toret;
+        // states do not move, so goal membership is checked once per vertex
+        bool is_in_goal(vertex& v)
+        {
+            if(v.in_goal < 0)
+                v.in_goal = system.is_in_goal(v.state);
+            return v.in_goal;
         }
 
         int update_best_vertex(vertex& v)
         {
-            if(system.is_in_goal(v.state))
+            if(is_in_goal(v))
             {
                 // implement goal cost here
                 if( (!lower_bound_vertex) || (v.cost_from_root < lower_bound_cost))
                 {
                     lower_bound_cost = v.cost_from_root;
                     lower_bound_vertex = &v;
+                    // unchecked paths must not shrink the informed set
+                    if(!lazy_collision_checking)
+                        system.set_informed_cost(root->state, lower_bound_cost.val.back());
                 }
             }
             return 0;
@@ -484,12 +685,12 @@ class rrts_c
             if(do_branch_and_bound)
             {
                 cost_t new_cost = vs.cost_from_root + e.cost; 
-                if(new_cost > lower_bound_cost)
+                if(new_cost > (lazy_collision_checking ? checked_cost : lower_bound_cost))
                     return NULL;
             }
 
             // create new vertex
-            vertex* new_vertex = new vertex(*(e.end_state));
+            vertex* new_vertex = vertex_pool.construct(*(e.end_state));
             insert_into_kdtree(*new_vertex);
 
             insert_edge(vs, e, *new_vertex);
@@ -505,7 +706,7 @@ class rrts_c
             update_best_vertex(ve);
 
             if(ve.edge_from_parent)
-                delete ve.edge_from_parent;
+                edge_pool.destroy(ve.edge_from_parent);
             ve.edge_from_parent = &e;
 
             if(ve.parent)
@@ -524,39 +725,49 @@ class rrts_c
         int find_best_parent(const state& si, const vector<vertex*>& near_vertices,
                 vertex*& best_parent, edge*& best_edge)
         {
+            SMPL_STAT(stats_timer_c timer(stats.parent_time));
+            SMPL_STAT(stats.steering_evaluations += near_vertices.size());
+            if(lazy_collision_checking)
+                return find_best_parent_lazy(si, near_vertices, best_parent, best_edge);
+            if(thread_pool)
+                return find_best_parent_parallel(si, near_vertices, best_parent, best_edge);
+
             // 1. create vertex_cost_pairs
             vector<pair<vertex*, cost_t> > vertex_cost_pairs;
-            unordered_map<vertex*, tuple<cost_t, cost_t, opt_data_t> > vertex_map;
+            unordered_map<vertex*, tuple<cost_t, cost_t, opt_data_t, double> > vertex_map;
             for(auto& pv : near_vertices)
             {
                 vertex& v = *pv;
                 opt_data_t opt_data;
                 cost_t edge_cost;
+                double edge_duration;
 
-                if(system.evaluate_extend_cost(v.state, si, opt_data, edge_cost))
+                if(system.evaluate_extend_cost(v.state, si, opt_data, edge_cost, edge_duration))
                     continue;
                 cost_t v_cost = v.cost_from_root + edge_cost;
 
                 vertex_cost_pairs.push_back(make_pair(pv, v_cost));
-                vertex_map.insert(make_pair(pv, make_tuple(edge_cost, v_cost, opt_data)));
+                vertex_map.insert(make_pair(pv, make_tuple(edge_cost, v_cost, opt_data, edge_duration)));
             }
 
             // 2. sort using compare function of cost_t
             sort(vertex_cost_pairs.begin(), vertex_cost_pairs.end(), compare_vertex_cost_pairs);
 
             // 3. check obstacles in order of increasing cost
-            bool check_obstacles = true;
-            trajectory_t traj;
             for(auto& p : vertex_cost_pairs)
             {
                 vertex& v = *(p.first);
                 opt_data_t& opt_data = get<2>(vertex_map[p.first]);
                 cost_t& edge_cost = get<0>(vertex_map[p.first]);
-                if(!system.extend_to(v.state, si, check_obstacles,traj, opt_data))
+                double edge_duration = get<3>(vertex_map[p.first]);
+                if(budget.past_deadline())
+                    return 1;
+                SMPL_STAT(stats.collision_checks++);
+                if(system.is_feasible(v.state, si, opt_data))
                 {
                     best_parent = &v;
-                    double edge_duration = system.dynamical_system.evaluate_extend_cost(v.state, si, opt_data);
-                    best_edge = new edge(&(v.state), &si, edge_cost, edge_duration, opt_data);
+                    best_edge = edge_pool.construct(&(v.state), &si, edge_cost, edge_duration, opt_data);
+                    best_edge->is_checked = true;
                     //cout<<"best_edge.cost: "<< best_edge.cost.val << endl;
                     return 0;
                 }
@@ -564,36 +775,177 @@ class rrts_c
             return 1;
         }
 
+        // same result as the serial loop: candidates are checked in rounds
+        // of num_speculative_checks and the cheapest feasible one wins
+        int find_best_parent_parallel(const state& si, const vector<vertex*>& near_vertices,
+                vertex*& best_parent, edge*& best_edge)
+        {
+            // 1. steering costs
+            vector<parent_candidate_t>& candidates = parent_candidates;
+            candidates.resize(near_vertices.size());
+            thread_pool->parallel_for(near_vertices.size(), [&](size_t i)
+            {
+                parent_candidate_t& c = candidates[i];
+                c.v = near_vertices[i];
+                c.opt_data = opt_data_t();
+                c.res = system.evaluate_extend_cost(c.v->state, si, c.opt_data, c.edge_cost, c.dt);
+                if(!c.res)
+                    c.cost = c.v->cost_from_root + c.edge_cost;
+            });
+
+            // 2. sort, cost_t::operator< is <= so ties are broken on the index
+            vector<size_t>& order = parent_order;
+            order.clear();
+            for(size_t i=0; i<candidates.size(); i++)
+            {
+                if(!candidates[i].res)
+                    order.push_back(i);
+            }
+            sort(order.begin(), order.end(), [&](size_t i1, size_t i2)
+            {
+                const cost_t& c1 = candidates[i1].cost;
+                const cost_t& c2 = candidates[i2].cost;
+                if((c1 < c2) && (c2 < c1))
+                    return i1 < i2;
+                return c1 < c2;
+            });
+
+            // 3. check obstacles for the next few candidates at once
+            size_t batch = num_speculative_checks ? num_speculative_checks : thread_pool->size();
+            for(size_t b=0; b<order.size(); b+=batch)
+            {
+                size_t nb = min(batch, order.size()-b);
+                if(budget.past_deadline())
+                    return 1;
+                SMPL_STAT(stats.collision_checks += nb);
+                thread_pool->parallel_for(nb, [&](size_t j)
+                {
+                    parent_candidate_t& c = candidates[order[b+j]];
+                    c.res = !system.is_feasible(c.v->state, si, c.opt_data);
+                });
+                for(size_t j=0; j<nb; j++)
+                {
+                    parent_candidate_t& c = candidates[order[b+j]];
+                    if(!c.res)
+                    {
+                        best_parent = c.v;
+                        best_edge = edge_pool.construct(&(c.v->state), &si, c.edge_cost, c.dt, c.opt_data);
+                        best_edge->is_checked = true;
+                        return 0;
+                    }
+                }
+            }
+            return 1;
+        }
+
+        // the cheapest parent by cost alone, the edge is left unchecked
+        int find_best_parent_lazy(const state& si, const vector<vertex*>& near_vertices,
+                vertex*& best_parent, edge*& best_edge)
+        {
+            best_parent = NULL;
+            cost_t best_cost, best_edge_cost;
+            opt_data_t best_opt_data;
+            double best_edge_duration = 0;
+            for(auto& pv : near_vertices)
+            {
+                opt_data_t opt_data;
+                cost_t edge_cost;
+                double edge_duration;
+                if(system.evaluate_extend_cost(pv->state, si, opt_data, edge_cost, edge_duration))
+                    continue;
+                cost_t v_cost = pv->cost_from_root + edge_cost;
+                if( (!best_parent) || (v_cost < best_cost))
+                {
+                    best_parent = pv;
+                    best_cost = v_cost;
+                    best_edge_cost = edge_cost;
+                    best_edge_duration = edge_duration;
+                    best_opt_data = opt_data;
+                }
+            }
+            if(!best_parent)
+                return 1;
+            best_edge = edge_pool.construct(&(best_parent->state), &si, best_edge_cost, best_edge_duration, best_opt_data);
+            return 0;
+        }
+
         int update_all_costs()
         {
             lower_bound_cost = system.get_inf_cost();
             lower_bound_vertex = NULL;
-            update_branch_cost(*root,0); 
+            checked_cost = system.get_inf_cost();
+            system.set_informed_cost(root->state, lower_bound_cost.val.back());
+            update_branch_cost(*root, true);
+            return 0;
+        }
+
+        // picks lower_bound_vertex again among the vertices that are not
+        // marked for deletion, when the costs are still valid
+        int update_best_vertex_all()
+        {
+            lower_bound_cost = system.get_inf_cost();
+            lower_bound_vertex = NULL;
+            checked_cost = system.get_inf_cost();
+            system.set_informed_cost(root->state, lower_bound_cost.val.back());
+            for(auto& pv : list_vertices)
+            {
+                if((pv != root) && !pv->mark)
+                    update_best_vertex(*pv);
+            }
             return 0;
         }
 
-        int update_branch_cost(const vertex& v, int depth)
+        static bool strictly_less(const cost_t& c1, const cost_t& c2)
         {
-            for(auto& pc : v.children)
+            return (c1 < c2) && !(c2 < c1);
+        }
+
+        // pushes the cost of v down its subtree on an explicit stack. Unless
+        // forced, the walk stops below children whose cost did not change.
+        int update_branch_cost(vertex& v, bool force=false)
+        {
+            SMPL_STAT(stats.cost_updates++);
+            SMPL_STAT(branch_depth_stack.assign(1, 0));
+            branch_stack.clear();
+            branch_stack.push_back(&v);
+            while(!branch_stack.empty())
             {
-                vertex& child = *(static_cast<vertex*>(pc));
-                child.cost_from_root = v.cost_from_root + child.cost_from_parent;
-                update_best_vertex(child); 
-                update_branch_cost(child, depth+1);
+                vertex& pv = *(branch_stack.back());
+                branch_stack.pop_back();
+                SMPL_STAT(size_t depth = branch_depth_stack.back() + 1);
+                SMPL_STAT(branch_depth_stack.pop_back());
+                for(auto& pc : pv.children)
+                {
+                    vertex& child = *(static_cast<vertex*>(pc));
+                    cost_t c = pv.cost_from_root + child.cost_from_parent;
+                    if(!force && !strictly_less(c, child.cost_from_root) && !strictly_less(child.cost_from_root, c))
+                        continue;
+                    child.cost_from_root = c;
+                    update_best_vertex(child);
+                    branch_stack.push_back(&child);
+                    SMPL_STAT(branch_depth_stack.push_back(depth));
+                    SMPL_STAT(stats.add_cost_depth(depth));
+                }
             }
             return 0;
         }
 
         int rewire_vertices(vertex& v, const vector<vertex*>& near_vertices, set<vertex*>* rewired_vertices)
         {
-            bool check_obstacles = true;
+            SMPL_STAT(stats_timer_c timer(stats.rewire_time));
+            SMPL_STAT(stats.steering_evaluations += near_vertices.size());
+            bool check_obstacles = !lazy_collision_checking;
             for(auto& pvn : near_vertices)
             {
+                if(budget.past_deadline())
+                    break;
                 vertex& vn = *pvn;
+                if(lazy_collision_checking && rejected_edges.count(make_pair(&v, pvn)))
+                    continue;
                 opt_data_t opt_data;
-                trajectory_t traj;
                 cost_t cost_edge;
-                if(system.evaluate_extend_cost(v.state, vn.state, opt_data, cost_edge))
+                double en_dt;
+                if(system.evaluate_extend_cost(v.state, vn.state, opt_data, cost_edge, en_dt))
                     continue;
 
                 if(rewired_vertices)
@@ -601,14 +953,16 @@ class rrts_c
                 cost_t cvn = v.cost_from_root + cost_edge;
                 if(cvn < vn.cost_from_root)
                 {
-                    if(system.extend_to(v.state, vn.state, check_obstacles, traj, opt_data))
+                    SMPL_STAT(stats.collision_checks += check_obstacles);
+                    if(check_obstacles && !system.is_feasible(v.state, vn.state, opt_data))
                         continue;
 
-                    double en_dt = system.dynamical_system.evaluate_extend_cost(v.state, vn.state, opt_data);
-                    edge* en = new edge(&(v.state), &(vn.state), cost_edge, en_dt, opt_data);
+                    edge* en = edge_pool.construct(&(v.state), &(vn.state), cost_edge, en_dt, opt_data);
+                    en->is_checked = check_obstacles;
                     insert_edge(v, *en, vn);
+                    SMPL_STAT(stats.rewires++);
 
-                    update_branch_cost(vn,0);
+                    update_branch_cost(vn);
                 }
             }
             return 0;
@@ -616,7 +970,7 @@ class rrts_c
 
         int recompute_cost(vertex& v)
         {
-            update_branch_cost(v,0);  
+            update_branch_cost(v);
             return 0;
         }
 
@@ -627,9 +981,16 @@ class rrts_c
 
         int mark_descendent_vertices(vertex& v)
         {
-            v.mark = 1;
-            for(auto& pc : v.children)
-                mark_descendent_vertices(*(static_cast<vertex*>(pc)));
+            branch_stack.clear();
+            branch_stack.push_back(&v);
+            while(!branch_stack.empty())
+            {
+                vertex& pv = *(branch_stack.back());
+                branch_stack.pop_back();
+                pv.mark = 1;
+                for(auto& pc : pv.children)
+                    branch_stack.push_back(static_cast<vertex*>(pc));
+            }
             return 0;
         }
 
@@ -644,17 +1005,59 @@ class rrts_c
                     surviving_vertices.push_back(pv);
                 }
                 else
-                    delete pv;
+                    free_vertex(pv);
+            }
+            return 0;
+        }
+
+        // frees the vertices with mark != keep_mark and takes them out of
+        // list_vertices and the kd-tree, one erase() per vertex. kd-trees
+        // that cannot erase are rebuilt from the survivors.
+        int remove_vertices(int keep_mark)
+        {
+            bool rebuild = false;
+            double key[num_dim];
+            rejected_edges.clear();
+            for(auto it = list_vertices.begin(); it != list_vertices.end(); )
+            {
+                vertex* pv = *it;
+                if(pv->mark == keep_mark)
+                {
+                    it++;
+                    continue;
+                }
+                if(!rebuild)
+                {
+                    system.get_key(pv->state, key);
+                    rebuild = kdtree.erase(key, pv);
+                }
+                if(pv == last_added_vertex)
+                    last_added_vertex = NULL;
+                if(removed_vertices)
+                    removed_vertices->push_back(pv);
+                free_vertex(pv);
+                it = list_vertices.erase(it);
+                num_vertices--;
+            }
+            if(rebuild)
+            {
+                kdtree.clear();
+                for(auto& pv : list_vertices)
+                {
+                    system.get_key(pv->state, key);
+                    kdtree.insert(key, pv);
+                }
             }
             return 0;
         }
 
+        // only v is detached, its descendants are just marked so that the
+        // children sets are not modified while they are iterated
         int mark_vertex_and_remove_from_parent(vertex& v)
         {
-            v.mark = 1;
-            v.parent->children.erase(&v);
-            for(auto& pc : v.children)
-                mark_vertex_and_remove_from_parent(*pc);
+            if(v.parent)
+                v.parent->children.erase(&v);
+            mark_descendent_vertices(v);
             return 0;
         }
 
@@ -663,38 +1066,24 @@ class rrts_c
         int delete_downstream(vertex& v)
         {
             mark_descendent_vertices(v);
-            list<vertex*> surviving_vertices;
-            for(auto& pv : list_vertices)
-            {
-                if(pv->mark == 0)
-                    surviving_vertices.push_back(pv);
-                else
-                    delete pv;
-            }
-            if(kdtree)
-                kd_free(kdtree);
-            kdtree = kd_create(num_dim);
-
-            list_vertices.clear();
-            num_vertices = 0;
-            for(auto& pv : surviving_vertices)
-                insert_into_kdtree(*pv); 
+            remove_vertices(0);
+            return 0;
         }
 
+        // checks the edges below v top-down, detaching the subtree below
+        // every colliding edge. The children sets are copied to a stack
+        // before any of them is modified.
         int check_and_mark_children(vertex& v)
         {
-            trajectory_t traj;
-            bool check_obstacles = true;
-
-            if(system.extend_to(v.parent->state, v.state, check_obstacles,
-                        traj, v.edge_from_parent->opt_data))
-            { 
-                mark_vertex_and_remove_from_parent(v);
-            }
-            else
+            vector<vertex*> stack(v.children.begin(), v.children.end());
+            while(!stack.empty())
             {
-                for(auto& pc : v.children)
-                    check_and_mark_children(*pc);
+                vertex& vc = *(stack.back());
+                stack.pop_back();
+                if(!system.is_feasible(vc.parent->state, vc.state, vc.edge_from_parent->opt_data))
+                    mark_vertex_and_remove_from_parent(vc);
+                else
+                    stack.insert(stack.end(), vc.children.begin(), vc.children.end());
             }
             return 0;
         }
@@ -709,29 +1098,9 @@ class rrts_c
             else if(!root->children.empty())
             {
                 root->mark = 0;
-
-                for(auto& prc : root->children)
-                    check_and_mark_children(*prc);
-
-                list<vertex*> surviving_vertices;
-                for(auto& pv : list_vertices)
-                {
-                    if(!pv->mark)
-                        surviving_vertices.push_back(pv);
-                    else
-                        delete pv;
-                }
-
-                if(kdtree)
-                    kd_free(kdtree);
-                kdtree = kd_create(num_dim);
-
-                list_vertices.clear();
-                num_vertices = 0;
-                for(auto& pv : surviving_vertices)
-                    insert_into_kdtree(*pv); 
-
-                update_all_costs();
+                check_and_mark_children(*root);
+                remove_vertices(0);
+                update_best_vertex_all();
             }
             return 0;
         }
@@ -744,8 +1113,150 @@ class rrts_c
             return ret;
         }
 
+        // pushes the edge from p to the detached vertex u on the repair
+        // heap, which holds indices into repair_edges, if it lowers the
+        // tentative cost kept in u.cost_from_root
+        int push_repair_edge(vertex& p, vertex& u)
+        {
+            repair_edge_t e;
+            if(system.evaluate_extend_cost(p.state, u.state, e.opt_data, e.edge_cost, e.dt))
+                return 1;
+            e.cost = p.cost_from_root + e.edge_cost;
+            if(!strictly_less(e.cost, u.cost_from_root) || rejected_edges.count(make_pair(&p, &u)))
+                return 1;
+            u.cost_from_root = e.cost;
+            e.v = &u;
+            e.parent = &p;
+            repair_edges.push_back(e);
+            repair_heap.push_back(repair_edges.size()-1);
+            push_heap(repair_heap.begin(), repair_heap.end(), repair_heap_compare_t(repair_edges));
+            return 0;
+        }
+
+        // v's edge from its parent collides. The subtree below v is
+        // detached and its vertices are attached again in order of cost,
+        // Dijkstra-like, each to its cheapest near vertex by cost alone,
+        // skipping rejected edges. Edges that stay keep their check. The
+        // vertices left over are marked for remove_vertices(0), returns 1
+        // then.
+        int repair_subtree(vertex& v)
+        {
+            rejected_edges.insert(make_pair(v.parent, &v));
+            v.parent->children.erase(&v);
+
+            vector<vertex*> subtree;
+            branch_stack.assign(1, &v);
+            while(!branch_stack.empty())
+            {
+                vertex* pv = branch_stack.back();
+                branch_stack.pop_back();
+                subtree.push_back(pv);
+                for(auto& pc : pv->children)
+                    branch_stack.push_back(static_cast<vertex*>(pc));
+                pv->children.clear();
+                pv->mark = 1;
+                pv->cost_from_root = system.get_inf_cost();
+            }
+
+            // edges into the subtree from the rest of the tree
+            repair_edges.clear();
+            repair_heap.clear();
+            unordered_map<vertex*, vector<vertex*> > near_map;
+            for(auto& pv : subtree)
+            {
+                vector<vertex*>& near_vertices = near_map[pv];
+                get_near_vertices(pv->state, near_vertices);
+                for(auto& pn : near_vertices)
+                {
+                    if(!pn->mark)
+                        push_repair_edge(*pn, *pv);
+                }
+            }
+
+            repair_heap_compare_t compare(repair_edges);
+            size_t num_left = subtree.size();
+            while(!repair_heap.empty() && num_left)
+            {
+                pop_heap(repair_heap.begin(), repair_heap.end(), compare);
+                repair_edge_t& e = repair_edges[repair_heap.back()];
+                repair_heap.pop_back();
+                vertex& u = *(e.v);
+                if((u.mark != 1) || strictly_less(u.cost_from_root, e.cost))
+                    continue;
+                if(u.parent == e.parent)
+                {
+                    u.cost_from_root = e.cost;
+                    e.parent->children.insert(&u);
+                    update_best_vertex(u);
+                }
+                else
+                {
+                    u.parent = NULL;
+                    edge* en = edge_pool.construct(&(e.parent->state), &(u.state), e.edge_cost, e.dt, e.opt_data);
+                    insert_edge(*(e.parent), *en, u);
+                }
+                u.mark = 0;
+                num_left--;
+                // e may move when repair_edges grows
+                for(auto& pn : near_map[&u])
+                {
+                    if(pn->mark == 1)
+                        push_repair_edge(u, *pn);
+                }
+            }
+            return num_left ? 1 : 0;
+        }
+
+        // collision checks the unchecked edges on the path to
+        // lower_bound_vertex from the root down. The subtree below a
+        // colliding edge is attached again, see repair_subtree(), and the
+        // next best path is checked. Returns 1 if no feasible path is left.
+        int check_best_path()
+        {
+            bool pruned = false;
+            list<vertex*> path;
+            while(lower_bound_vertex)
+            {
+                path.clear();
+                for(vertex* pv = lower_bound_vertex; pv->parent; pv = pv->parent)
+                    path.push_front(pv);
+
+                vertex* colliding = NULL;
+                for(auto& pv : path)
+                {
+                    edge& e = *(pv->edge_from_parent);
+                    if(e.is_checked)
+                        continue;
+                    SMPL_STAT(stats.collision_checks++);
+                    if(!system.is_feasible(pv->parent->state, pv->state, e.opt_data))
+                    {
+                        colliding = pv;
+                        break;
+                    }
+                    e.is_checked = true;
+                }
+                if(!colliding)
+                    break;
+
+                if(repair_subtree(*colliding))
+                    pruned = true;
+                update_best_vertex_all();
+            }
+
+            if(pruned)
+                remove_vertices(0);
+            if(lower_bound_vertex)
+            {
+                checked_cost = lower_bound_cost;
+                system.set_informed_cost(root->state, checked_cost.val.back());
+            }
+            return lower_bound_vertex ? 0 : 1;
+        }
+
         int get_best_trajectory_vertices(list<vertex*>& best_trajectory_vertices)
         {
+            if(lazy_collision_checking)
+                check_best_path();
             if(!lower_bound_vertex)
                 return 1;
             best_trajectory_vertices.clear();
@@ -782,6 +1293,7 @@ class rrts_c
 
             bool check_obstacles = false;
             double length = 0;
+            trajectory_t buffer;
 
             state new_root_state;
             vertex* child_of_new_root_vertex = NULL;
@@ -793,12 +1305,11 @@ class rrts_c
                     break;
                 if(vc.parent)
                 {
-                    vertex& parent = *(vc.parent);
-                    trajectory_t traj;
                     // traj connects parent with vc!
-                    if(!system.extend_to(parent.state, vc.state, check_obstacles,
-                                traj, vc.edge_from_parent->opt_data))
+                    const trajectory_t* ptraj;
+                    if(!get_edge_trajectory(vc, ptraj, buffer, false))
                     {
+                        const trajectory_t& traj = *ptraj;
                         // 1.a go ahead until reach the edge with the root
                         if( (length + traj.total_variation) < distance)
                         {
@@ -821,7 +1332,9 @@ class rrts_c
                                 {
                                     length = length + t1;
                                     committed_trajectory.states.push_back(sc);
-                                    committed_trajectory.controls.push_back(*cc);
+                                    // edges may carry fewer controls than states
+                                    committed_trajectory.controls.push_back(
+                                            (cc != traj.controls.end()) ? *cc : control());
                                     committed_trajectory.total_variation += t1;
                                 }
                                 else
@@ -831,7 +1344,8 @@ class rrts_c
                                     new_root_found = true;
                                     break;
                                 }
-                                cc++;
+                                if(cc != traj.controls.end())
+                                    cc++;
                             }
                         }
                     }
@@ -854,9 +1368,7 @@ class rrts_c
                 if(!child_of_new_root_vertex)
                 {
                     clear_list_vertices();
-                    if(kdtree)
-                        kd_free(kdtree);
-                    kdtree = kd_create(num_dim);
+                    kdtree.clear();
 
                     set_root(new_root_state);
                     update_all_costs();
@@ -864,21 +1376,20 @@ class rrts_c
                 }
                 else
                 {
+                    // the old root goes with the vertices that are not
+                    // below the new one
                     mark_descendent_vertices(*child_of_new_root_vertex);
-
-                    vector<vertex*> surviving_vertices;
-                    delete_unmarked_vertices(surviving_vertices);
-
-                    list_vertices.clear();
-                    num_vertices = 0;
-                    if(kdtree)
-                        kd_free(kdtree);
-                    kdtree = kd_create(num_dim);
+                    remove_vertices(1);
+                    for(auto& pv : list_vertices)
+                        pv->mark = 0;
 
                     set_root(new_root_state);
 
                     if(child_of_new_root_vertex->edge_from_parent)
-                        delete child_of_new_root_vertex->edge_from_parent;
+                    {
+                        edge_pool.destroy(child_of_new_root_vertex->edge_from_parent);
+                        child_of_new_root_vertex->edge_from_parent = NULL;
+                    }
 
                     trajectory_t new_root_traj;
                     opt_data_t opt_data;
@@ -887,21 +1398,18 @@ class rrts_c
                         return 5;
 
                     cost_t child_of_new_root_edge_cost;
+                    double child_of_new_root_edge_dt;
                     if(system.evaluate_extend_cost(new_root_state, child_of_new_root_vertex->state,
-                                opt_data, child_of_new_root_edge_cost))
+                                opt_data, child_of_new_root_edge_cost, child_of_new_root_edge_dt))
                         return 6;
-                    child_of_new_root_vertex->edge_from_parent = new edge(&new_root_state,
+                    child_of_new_root_vertex->edge_from_parent = edge_pool.construct(&(root->state),
                             &child_of_new_root_vertex->state,
-                            child_of_new_root_edge_cost, opt_data);
+                            child_of_new_root_edge_cost, child_of_new_root_edge_dt, opt_data);
                     child_of_new_root_vertex->parent = root;
                     child_of_new_root_vertex->cost_from_parent = 
                         child_of_new_root_vertex->edge_from_parent->cost;
                     root->children.insert(child_of_new_root_vertex);
 
-                    // root was already inserted in set_root
-                    for(auto& pv : surviving_vertices)
-                        insert_into_kdtree(*pv);
-
                     update_all_costs();
                     return 0;
                 }
@@ -910,81 +1418,81 @@ class rrts_c
                 return 3;
         }
 
-        virtual void plot_trajectory(trajectory_t& traj, double* lc, double width)
+        void set_plotter(plotter_c* plotter_in)
         {
-            bot_lcmgl_color4f(lcmgl, lc[0], lc[1], lc[2], lc[3]);
-            bot_lcmgl_line_width(lcmgl, width);
-            bot_lcmgl_begin(lcmgl, GL_LINES);
-            for(auto pts = traj.states.begin(); pts != traj.states.end(); pts++)
-            {
-                double s2[3] = {0};
-                system.get_plotter_state(*pts, s2);
-                bot_lcmgl_vertex3d(lcmgl, s2[0], s2[1], s2[2]);
-
-                auto npts = pts;
-                npts++;
-                if(npts != traj.states.end()){
-                    system.get_plotter_state(*npts, s2);
-                    bot_lcmgl_vertex3d(lcmgl, s2[0], s2[1], s2[2]);
-                }
-            }
-            bot_lcmgl_end(lcmgl);
+            plotter = plotter_in;
         }
 
-        virtual void plot_tree()
+        // the vertices and edges of the tree in plotter coordinates, works
+        // without a plotter
+        int get_tree_snapshot(plot_snapshot_c& snapshot)
         {
-            bool check_obstacles = false;
             if(num_vertices == 0)
-                return;
+                return 0;
+            plot_points_t& points = snapshot.add_points(points_color, points_size);
+            plot_lines_t& lines = snapshot.add_lines(lines_color, lines_width);
+            trajectory_t buffer;
             for(auto& v : list_vertices)
             {
                 double s1[3] = {0};
                 system.get_plotter_state(v->state, s1);
-                bot_lcmgl_color4f(lcmgl, points_color[0], points_color[1], points_color[2], points_color[3]);
-                bot_lcmgl_point_size(lcmgl, points_size);
-                bot_lcmgl_begin(lcmgl, GL_POINTS);
-                bot_lcmgl_vertex3d(lcmgl, s1[0], s1[1], s1[2]);
-                bot_lcmgl_end(lcmgl);
+                points.xyz.insert(points.xyz.end(), s1, s1+3);
 
                 if(v->parent){
-                    trajectory_t traj_from_parent;
-                    if(system.extend_to(v->parent->state, v->state, check_obstacles,
-                                traj_from_parent, v->edge_from_parent->opt_data)){
+                    const trajectory_t* traj_from_parent;
+                    if(get_edge_trajectory(*v, traj_from_parent, buffer, false)){
                         cout<<"extend_to returns 1 while plotting"<<endl;
-                        return;
+                        return 1;
                     }
-                    plot_trajectory(traj_from_parent, lines_color, lines_width);
+                    plot_snapshot_c::add_trajectory(system, *traj_from_parent, lines);
                 }
             }
+            return 0;
+        }
+
+        virtual void plot_trajectory(const trajectory_t& traj, double* lc, double width)
+        {
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            plot_snapshot_c::add_trajectory(system, traj, snapshot.add_lines(lc, width));
+            plotter->draw(snapshot);
+        }
+
+        virtual void plot_tree()
+        {
+            if(!plotter || (num_vertices == 0))
+                return;
+            plot_snapshot_c snapshot;
+            get_tree_snapshot(snapshot);
+            plotter->draw(snapshot);
         }
 
         virtual void plot_best_trajectory()
         {
             trajectory_t best_trajectory;
-            if(get_best_trajectory(best_trajectory))
+            if(!plotter || get_best_trajectory(best_trajectory))
                 return;
             plot_trajectory(best_trajectory, best_lines_color, best_lines_width); 
         }
 
         void plot_region(region_t& r, int dim=3)
         {
-            double c[3] = {0};
-            double s[3] = {0};
-            float sf[3] = {0};
-            r.get_plotter_state(c, s, dim);
-            bot_lcmgl_color4f(lcmgl, r.color[0], r.color[1], r.color[2], r.color[3]);
-            for(int i=0; i<3; i++)
-                sf[i] = s[i];
-
-            bot_lcmgl_box(lcmgl, c, sf);
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            snapshot.add_region(r, dim);
+            plotter->draw(snapshot);
         }
 
         virtual void plot_environment()
         {
-            bot_lcmgl_enable(lcmgl, GL_BLEND);
-
-            plot_region(system.operating_region);
-            plot_region(system.goal_region);
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            snapshot.add_region(system.operating_region);
+            snapshot.add_region(system.goal_region);
+            plotter->draw(snapshot);
         }
 };
 #endif
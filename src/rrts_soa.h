@@ -0,0 +1,671 @@
+#ifndef __rrts_soa_h__
+#define __rrts_soa_h__
+
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <stdint.h>
+#include "kd_tree.h"
+
+#include "system.h"
+#include "utils.h"
+
+#include "plotter.h"
+
+using namespace std;
+
+/*
+ * RRT* with the tree stored as a struct of arrays. Vertex i is the i-th
+ * entry of every array: its state, costs, the edge from its parent
+ * (opt_data, dt) and 32-bit parent, first-child and next-sibling ids.
+ * The kd-tree stores ids, the root is id 0. There are no per-vertex heap
+ * allocations besides those of cost_t and opt_data_t, and whole-tree
+ * passes run over contiguous memory.
+ *
+ * The public interface follows rrts_c: initialize, iteration,
+ * get_best_cost, get_best_trajectory, check_tree and the plotting calls.
+ * Vertices are addressed by id instead of vertex_c pointers. check_tree
+ * compacts the arrays, ids change when vertices are deleted. switch_root,
+ * lazy_collision_checking, trajectory caching and find_best_parent on a
+ * thread pool are not available.
+ */
+template<class system_tt,
+    class kdtree_tt = kdtree_c<system_tt::N, uint32_t> >
+class rrts_soa_c
+{
+    public:
+        typedef system_tt system_t;
+        typedef typename system_t::state state;
+        typedef typename system_t::control control;
+        typedef typename system_t::opt_data_t opt_data_t;
+        typedef typename system_t::trajectory trajectory_t;
+        typedef typename system_t::cost_t cost_t;
+        typedef typename system_t::region_t region_t;
+        typedef kdtree_tt kdtree_t;
+        typedef uint32_t vertex_id_t;
+
+        const static size_t num_dim = system_t::N;
+        const static vertex_id_t no_vertex = UINT32_MAX;
+
+        system_t system;
+
+        int num_vertices;
+        double gamma;
+        double goal_sample_freq;
+        bool do_branch_and_bound;
+        bool use_k_nearest;
+        double k_rrt;
+
+        cost_t lower_bound_cost;
+        vertex_id_t lower_bound_vertex;
+        vertex_id_t last_added_vertex;
+
+        // the tree, one entry per vertex
+        vector<state> states;
+        vector<cost_t> cost_from_root;
+        vector<cost_t> cost_from_parent;
+        vector<double> t0;
+        vector<vertex_id_t> parent;
+        vector<vertex_id_t> first_child;
+        vector<vertex_id_t> next_sibling;
+        vector<opt_data_t> edge_opt_data;
+        vector<double> edge_dt;
+        vector<uint8_t> in_goal;
+
+        kdtree_t kdtree;
+
+        // draws the snapshots of the plot_* calls, may be NULL
+        plotter_c* plotter;
+        double points_color[4];
+        double points_size;
+        double lines_color[4];
+        double lines_width;
+        double best_lines_color[4];
+        double best_lines_width;
+
+        rrts_soa_c()
+        {
+            plotter = NULL;
+            basic_initialization();
+        }
+        rrts_soa_c(plotter_c* plotter_in)
+        {
+            plotter = plotter_in;
+            basic_initialization();
+        }
+
+        void set_points_color(double* pc, double ps)
+        {
+            for(int i : range(0,4))
+                points_color[i] = pc[i];
+            points_size = ps;
+        }
+
+        void set_lines_color(double* lc, double lw)
+        {
+            for(int i : range(0,4))
+                lines_color[i] = lc[i];
+            lines_width = lw;
+        }
+
+        void set_best_lines_color(double* blc, double blw)
+        {
+            for(int i : range(0,4))
+                best_lines_color[i] = blc[i];
+            best_lines_width = blw;
+        }
+
+        void basic_initialization()
+        {
+            gamma = 2.5;
+            goal_sample_freq = 0.1;
+            do_branch_and_bound = true;
+            use_k_nearest = false;
+            k_rrt = 1.1*(M_E + M_E/(double)num_dim);
+
+            lower_bound_vertex = no_vertex;
+            last_added_vertex = no_vertex;
+            num_vertices = 0;
+
+            double pc[4] = {1,1,0,0.9};
+            double lc[4] = {1,1,1,0.5};
+            double blc[4] = {1,0,0,0.8};
+            set_points_color(pc, 4);
+            set_lines_color(lc, 1.5);
+            set_best_lines_color(blc, 4);
+        }
+
+        void clear_vertices()
+        {
+            states.clear();
+            cost_from_root.clear();
+            cost_from_parent.clear();
+            t0.clear();
+            parent.clear();
+            first_child.clear();
+            next_sibling.clear();
+            edge_opt_data.clear();
+            edge_dt.clear();
+            in_goal.clear();
+            kdtree.clear();
+            num_vertices = 0;
+        }
+
+        // reserves room for n vertices in every array
+        void reserve(size_t n)
+        {
+            states.reserve(n);
+            cost_from_root.reserve(n);
+            cost_from_parent.reserve(n);
+            t0.reserve(n);
+            parent.reserve(n);
+            first_child.reserve(n);
+            next_sibling.reserve(n);
+            edge_opt_data.reserve(n);
+            edge_dt.reserve(n);
+            in_goal.reserve(n);
+            kdtree.reserve(n);
+        }
+
+        int initialize(const state& rs, bool do_branch_and_bound_in=true)
+        {
+            clear_vertices();
+            lower_bound_cost = system.get_inf_cost();
+            lower_bound_vertex = no_vertex;
+            system.set_informed_cost(rs, lower_bound_cost.val.back());
+            do_branch_and_bound = do_branch_and_bound_in;
+
+            vertex_id_t r = add_vertex(rs);
+            cost_from_root[r] = system.get_zero_cost();
+            cost_from_parent[r] = system.get_zero_cost();
+            print_state(rs, cout, "set root to:", "\n");
+            last_added_vertex = r;
+            return 0;
+        }
+
+        int iteration(state* s_in = NULL)
+        {
+            last_added_vertex = no_vertex;
+
+            // 1. sample
+            state sr;
+            if(!s_in)
+            {
+                int ret = 0;
+                double p = system.rng.uniform();
+                if(p < goal_sample_freq)
+                    ret = system.sample_in_goal(sr);
+                else
+                    ret = system.sample_state(sr);
+                if(ret)
+                    return 1;
+            }
+            else
+                sr = *s_in;
+
+            // 2. compute nearest vertices
+            near_vertices.clear();
+            if(get_near_vertices(sr, near_vertices))
+                return 2;
+
+            // 3. best parent, candidates[0] holds the connection
+            if(find_best_parent(sr, near_vertices))
+                return 3;
+            candidate_t& best = candidates[0];
+
+            // 4. branch and bound, then draw the edge from the parent
+            if(do_branch_and_bound && (best.cost > lower_bound_cost))
+                return 5;
+            vertex_id_t nv = add_vertex(sr);
+            set_parent(nv, best.v, best.edge_cost, best.dt, best.opt_data);
+            update_best_vertex(nv);
+
+            // 5. rewire
+            rewire_vertices(nv, near_vertices);
+
+            last_added_vertex = nv;
+            return 0;
+        }
+
+        const state& get_state(vertex_id_t v) const {return states[v];}
+        vertex_id_t get_parent(vertex_id_t v) const {return parent[v];}
+        const cost_t& get_cost(vertex_id_t v) const {return cost_from_root[v];}
+        cost_t get_best_cost() {return lower_bound_cost;}
+
+        int get_trajectory_root(vertex_id_t v, trajectory_t& root_traj)
+        {
+            root_traj.clear();
+            path.clear();
+            for(vertex_id_t vc = v; parent[vc] != no_vertex; vc = parent[vc])
+                path.push_back(vc);
+
+            root_traj.states.push_back(states[0]);
+            root_traj.controls.push_back(control());
+
+            trajectory_t traj;
+            for(auto it = path.rbegin(); it != path.rend(); it++)
+            {
+                if(get_edge_trajectory(*it, traj))
+                    continue;
+                root_traj.append(traj);
+            }
+            root_traj.t0 = 0;
+            root_traj.dt = 0.05;
+            return 0;
+        }
+
+        int get_best_trajectory(trajectory_t& best_traj)
+        {
+            if(lower_bound_vertex == no_vertex)
+                return 1;
+            return get_trajectory_root(lower_bound_vertex, best_traj);
+        }
+
+        // ids from the root to lower_bound_vertex
+        int get_best_trajectory_vertices(vector<vertex_id_t>& best_trajectory_vertices)
+        {
+            if(lower_bound_vertex == no_vertex)
+                return 1;
+            best_trajectory_vertices.clear();
+            for(vertex_id_t vc = lower_bound_vertex; vc != no_vertex; vc = parent[vc])
+                best_trajectory_vertices.push_back(vc);
+            reverse(best_trajectory_vertices.begin(), best_trajectory_vertices.end());
+            return 0;
+        }
+
+        // checks every edge again and deletes the subtrees below the ones
+        // that collide. Ids of the surviving vertices change.
+        int check_tree()
+        {
+            if(system.is_in_collision(states[0]))
+            {
+                cout<<"root in collision"<<endl;
+                return 1;
+            }
+
+            vector<uint8_t> keep(num_vertices, 0);
+            keep[0] = 1;
+            stack.clear();
+            stack.push_back(0);
+            while(!stack.empty())
+            {
+                vertex_id_t v = stack.back();
+                stack.pop_back();
+                for(vertex_id_t c = first_child[v]; c != no_vertex; c = next_sibling[c])
+                {
+                    if(!system.is_feasible(states[v], states[c], edge_opt_data[c]))
+                        continue;
+                    keep[c] = 1;
+                    stack.push_back(c);
+                }
+            }
+            compact(keep);
+            update_best_vertex_all();
+            return 0;
+        }
+
+        int lazy_check_tree(const trajectory_t& committed_trajectory)
+        {
+            if(!system.is_safe_trajectory(committed_trajectory))
+                return check_tree();
+            return 0;
+        }
+
+        void set_plotter(plotter_c* plotter_in)
+        {
+            plotter = plotter_in;
+        }
+
+        // the vertices and edges of the tree in plotter coordinates, works
+        // without a plotter
+        int get_tree_snapshot(plot_snapshot_c& snapshot)
+        {
+            if(num_vertices == 0)
+                return 0;
+            plot_points_t& points = snapshot.add_points(points_color, points_size);
+            plot_lines_t& lines = snapshot.add_lines(lines_color, lines_width);
+            trajectory_t traj;
+            for(int v=0; v<num_vertices; v++)
+            {
+                double s1[3] = {0};
+                system.get_plotter_state(states[v], s1);
+                points.xyz.insert(points.xyz.end(), s1, s1+3);
+
+                if(parent[v] != no_vertex){
+                    if(get_edge_trajectory(v, traj)){
+                        cout<<"extend_to returns 1 while plotting"<<endl;
+                        return 1;
+                    }
+                    plot_snapshot_c::add_trajectory(system, traj, lines);
+                }
+            }
+            return 0;
+        }
+
+        virtual void plot_trajectory(const trajectory_t& traj, double* lc, double width)
+        {
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            plot_snapshot_c::add_trajectory(system, traj, snapshot.add_lines(lc, width));
+            plotter->draw(snapshot);
+        }
+
+        virtual void plot_tree()
+        {
+            if(!plotter || (num_vertices == 0))
+                return;
+            plot_snapshot_c snapshot;
+            get_tree_snapshot(snapshot);
+            plotter->draw(snapshot);
+        }
+
+        virtual void plot_best_trajectory()
+        {
+            trajectory_t best_trajectory;
+            if(!plotter || get_best_trajectory(best_trajectory))
+                return;
+            plot_trajectory(best_trajectory, best_lines_color, best_lines_width);
+        }
+
+        void plot_region(region_t& r, int dim=3)
+        {
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            snapshot.add_region(r, dim);
+            plotter->draw(snapshot);
+        }
+
+        virtual void plot_environment()
+        {
+            if(!plotter)
+                return;
+            plot_snapshot_c snapshot;
+            snapshot.add_region(system.operating_region);
+            snapshot.add_region(system.goal_region);
+            plotter->draw(snapshot);
+        }
+
+    protected:
+        struct candidate_t
+        {
+            vertex_id_t v;
+            cost_t edge_cost;
+            cost_t cost;
+            opt_data_t opt_data;
+            double dt;
+        };
+        vector<candidate_t> candidates;
+        vector<size_t> order;
+        vector<vertex_id_t> near_vertices;
+        vector<vertex_id_t> stack;
+        vector<vertex_id_t> path;
+
+        static bool strictly_less(const cost_t& c1, const cost_t& c2)
+        {
+            return (c1 < c2) && !(c2 < c1);
+        }
+
+        vertex_id_t add_vertex(const state& s)
+        {
+            vertex_id_t v = num_vertices++;
+            states.push_back(s);
+            cost_from_root.push_back(cost_t());
+            cost_from_parent.push_back(cost_t());
+            t0.push_back(0);
+            parent.push_back(no_vertex);
+            first_child.push_back(no_vertex);
+            next_sibling.push_back(no_vertex);
+            edge_opt_data.push_back(opt_data_t());
+            edge_dt.push_back(0);
+            in_goal.push_back(system.is_in_goal(s));
+
+            double key[num_dim];
+            system.get_key(s, key);
+            kdtree.insert(key, v);
+            return v;
+        }
+
+        // unlinks v from the children of its parent, the list is short
+        void remove_child(vertex_id_t v)
+        {
+            vertex_id_t p = parent[v];
+            if(p == no_vertex)
+                return;
+            if(first_child[p] == v)
+            {
+                first_child[p] = next_sibling[v];
+                return;
+            }
+            for(vertex_id_t c = first_child[p]; c != no_vertex; c = next_sibling[c])
+            {
+                if(next_sibling[c] == v)
+                {
+                    next_sibling[c] = next_sibling[v];
+                    return;
+                }
+            }
+        }
+
+        void set_parent(vertex_id_t v, vertex_id_t p, const cost_t& edge_cost,
+                double dt, const opt_data_t& opt_data)
+        {
+            remove_child(v);
+            parent[v] = p;
+            next_sibling[v] = first_child[p];
+            first_child[p] = v;
+
+            edge_opt_data[v] = opt_data;
+            edge_dt[v] = dt;
+            t0[v] = t0[p] + dt;
+            cost_from_parent[v] = edge_cost;
+            cost_from_root[v] = cost_from_root[p] + edge_cost;
+        }
+
+        int get_edge_trajectory(vertex_id_t v, trajectory_t& traj)
+        {
+            bool check_obstacles = false;
+            return system.extend_to(states[parent[v]], states[v], check_obstacles,
+                    traj, edge_opt_data[v]);
+        }
+
+        int get_near_vertices(const state& s, vector<vertex_id_t>& near)
+        {
+            double key[num_dim];
+            system.get_key(s, key);
+
+            if(use_k_nearest)
+            {
+                size_t k = ceil(k_rrt*log(num_vertices + 1.0));
+                if(!kdtree.nearest_n(key, k, near))
+                    return 1;
+                return 0;
+            }
+
+            double rn = gamma*pow(system.get_informed_volume_fraction()*log(num_vertices + 1.0)/(num_vertices+1.0),
+                    1.0/(double)num_dim);
+            if(!kdtree.near_range(key, rn, near))
+            {
+                vertex_id_t vc;
+                if(kdtree.nearest(key, vc))
+                    return 1;
+                near.push_back(vc);
+            }
+            return 0;
+        }
+
+        // collision checks the candidates in order of cost, the feasible
+        // one is moved to candidates[0]
+        int find_best_parent(const state& si, const vector<vertex_id_t>& near)
+        {
+            candidates.clear();
+            order.clear();
+            for(auto& v : near)
+            {
+                candidate_t c;
+                c.v = v;
+                if(system.evaluate_extend_cost(states[v], si, c.opt_data, c.edge_cost, c.dt))
+                    continue;
+                c.cost = cost_from_root[v] + c.edge_cost;
+                order.push_back(candidates.size());
+                candidates.push_back(c);
+            }
+
+            sort(order.begin(), order.end(), [&](size_t i1, size_t i2)
+            {
+                const cost_t& c1 = candidates[i1].cost;
+                const cost_t& c2 = candidates[i2].cost;
+                if(strictly_less(c1, c2))
+                    return true;
+                if(strictly_less(c2, c1))
+                    return false;
+                return i1 < i2;
+            });
+
+            for(auto& i : order)
+            {
+                candidate_t& c = candidates[i];
+                if(system.is_feasible(states[c.v], si, c.opt_data))
+                {
+                    if(i)
+                        swap(candidates[0], c);
+                    return 0;
+                }
+            }
+            return 1;
+        }
+
+        int update_best_vertex(vertex_id_t v)
+        {
+            if(!in_goal[v])
+                return 0;
+            if((lower_bound_vertex == no_vertex) || (cost_from_root[v] < lower_bound_cost))
+            {
+                lower_bound_cost = cost_from_root[v];
+                lower_bound_vertex = v;
+                system.set_informed_cost(states[0], lower_bound_cost.val.back());
+            }
+            return 0;
+        }
+
+        int update_best_vertex_all()
+        {
+            lower_bound_cost = system.get_inf_cost();
+            lower_bound_vertex = no_vertex;
+            system.set_informed_cost(states[0], lower_bound_cost.val.back());
+            for(int v=1; v<num_vertices; v++)
+                update_best_vertex(v);
+            return 0;
+        }
+
+        // pushes the cost of v down its subtree, costs only drop when
+        // rewiring so the walk stops below children that do not improve
+        int update_branch_cost(vertex_id_t v)
+        {
+            stack.clear();
+            stack.push_back(v);
+            while(!stack.empty())
+            {
+                vertex_id_t p = stack.back();
+                stack.pop_back();
+                for(vertex_id_t c = first_child[p]; c != no_vertex; c = next_sibling[c])
+                {
+                    cost_t cc = cost_from_root[p] + cost_from_parent[c];
+                    if(!strictly_less(cc, cost_from_root[c]))
+                        continue;
+                    cost_from_root[c] = cc;
+                    t0[c] = t0[p] + edge_dt[c];
+                    update_best_vertex(c);
+                    stack.push_back(c);
+                }
+            }
+            return 0;
+        }
+
+        int rewire_vertices(vertex_id_t v, const vector<vertex_id_t>& near)
+        {
+            for(auto& vn : near)
+            {
+                if(vn == parent[v])
+                    continue;
+                opt_data_t opt_data;
+                cost_t cost_edge;
+                double en_dt;
+                if(system.evaluate_extend_cost(states[v], states[vn], opt_data, cost_edge, en_dt))
+                    continue;
+
+                cost_t cvn = cost_from_root[v] + cost_edge;
+                if(cvn < cost_from_root[vn])
+                {
+                    if(!system.is_feasible(states[v], states[vn], opt_data))
+                        continue;
+                    set_parent(vn, v, cost_edge, en_dt, opt_data);
+                    update_best_vertex(vn);
+                    update_branch_cost(vn);
+                }
+            }
+            return 0;
+        }
+
+        // moves the kept vertices to the front of every array in their
+        // current order, relinks the children and rebuilds the kd-tree
+        int compact(const vector<uint8_t>& keep)
+        {
+            vector<vertex_id_t> new_id(num_vertices, no_vertex);
+            vertex_id_t n = 0;
+            for(int v=0; v<num_vertices; v++)
+            {
+                if(keep[v])
+                    new_id[v] = n++;
+            }
+            for(int v=0; v<num_vertices; v++)
+            {
+                vertex_id_t nv = new_id[v];
+                if((nv == no_vertex) || (nv == (vertex_id_t)v))
+                    continue;
+                states[nv] = states[v];
+                cost_from_root[nv] = cost_from_root[v];
+                cost_from_parent[nv] = cost_from_parent[v];
+                t0[nv] = t0[v];
+                parent[nv] = parent[v];
+                edge_opt_data[nv] = edge_opt_data[v];
+                edge_dt[nv] = edge_dt[v];
+                in_goal[nv] = in_goal[v];
+            }
+
+            states.resize(n);
+            cost_from_root.resize(n);
+            cost_from_parent.resize(n);
+            t0.resize(n);
+            parent.resize(n);
+            first_child.assign(n, no_vertex);
+            next_sibling.assign(n, no_vertex);
+            edge_opt_data.resize(n);
+            edge_dt.resize(n);
+            in_goal.resize(n);
+            num_vertices = n;
+
+            kdtree.clear();
+            double key[num_dim];
+            for(vertex_id_t v=0; v<n; v++)
+            {
+                if(parent[v] != no_vertex)
+                {
+                    vertex_id_t p = new_id[parent[v]];
+                    parent[v] = p;
+                    next_sibling[v] = first_child[p];
+                    first_child[p] = v;
+                }
+                system.get_key(states[v], key);
+                kdtree.insert(key, v);
+            }
+            if(last_added_vertex != no_vertex)
+                last_added_vertex = new_id[last_added_vertex];
+            return 0;
+        }
+};
+
+template<class system_tt, class kdtree_tt>
+const typename rrts_soa_c<system_tt, kdtree_tt>::vertex_id_t rrts_soa_c<system_tt, kdtree_tt>::no_vertex;
+#endif
@@ -36,10 +36,11 @@ class single_integrator_c : public dynamical_system_c<state_c<N>, control_c<N>,
       return 0;
     }
 
-    int sample_state(double* center, double* size, double* s)
+    int sample_state(double* center, double* size, double* s, random_c& rng)
     {
+      rng.uniform(s, N);
       for(int i : range(0,N))
-        s[i] = center[i] + (RANDF-0.5)*size[i];
+        s[i] = center[i] + (s[i]-0.5)*size[i];
       return 0;
     }
 
@@ -66,6 +67,38 @@ class single_integrator_c : public dynamical_system_c<state_c<N>, control_c<N>,
       return 0;
     }
 
+    // the states of extend_to, generated in place
+    int steer(const state_t& si, const state_t& sf, single_integrator_opt_data_t& opt_data,
+        size_t stride, const state_block_callback_t& cb)
+    {
+      double dist = evaluate_extend_cost(si, sf, opt_data);
+      int num_points = ceil(dist/delta_distance);
+
+      double step[N];
+      if(normalize_diff(si, sf, double(1.0/num_points), step)!=0)
+        return 1;
+
+      state_block_writer_c<N> writer(cb);
+      state_t cur_state = si;
+      if(int res = writer.push(cur_state.x))
+        return res;
+      for(int i=1; i<num_points; i++)
+      {
+        for(size_t j=0; j<N; j++)
+          cur_state.x[j] += step[j];
+        if(i % stride)
+          continue;
+        if(int res = writer.push(cur_state.x))
+          return res;
+      }
+      return writer.flush();
+    }
+
+    size_t get_euclidean_bound_dim()
+    {
+      return N;
+    }
+
     double evaluate_extend_cost(const state_t& si, const state_t& sf,
         single_integrator_opt_data_t& opt_data)
     {
@@ -79,7 +112,7 @@ class single_integrator_c : public dynamical_system_c<state_c<N>, control_c<N>,
       state_t origin(zero);
       double goal[N] = {10};
       state_t sr(goal);
-      sr.print(cout, "sampled:","\n");
+      print_state(sr, cout, "sampled:", "\n");
 
       optimization_data_c opt_data;
       extend_to(origin, sr, traj, opt_data);
@@ -0,0 +1,109 @@
+#ifndef __stats_h__
+#define __stats_h__
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+using namespace std;
+
+/*
+ * Counters and timers of the phases of rrts_c::iteration. They are only
+ * kept if smpl is built with SMPL_STATS defined (cmake -DSMPL_STATS=ON),
+ * otherwise SMPL_STAT(..) expands to nothing and get_stats() stays zero.
+ */
+#ifdef SMPL_STATS
+#define SMPL_STAT(x) x
+#else
+#define SMPL_STAT(x)
+#endif
+
+struct rrts_stats_t
+{
+    // iteration() calls, and those that added a vertex
+    size_t iterations, added_vertices;
+    // sample_state/sample_in_goal calls, and the draws system_c threw away
+    // because they were in collision or could not improve the informed cost
+    size_t samples, rejected_samples;
+    // get_near_vertices calls and the number of vertices they returned
+    size_t near_queries, near_vertices, max_near_vertices;
+    // evaluate_extend_cost calls of find_best_parent and rewire_vertices
+    size_t steering_evaluations;
+    // is_feasible calls of find_best_parent and rewire_vertices, the
+    // edges that went into the tree are added_vertices + rewires
+    size_t collision_checks;
+    size_t rewires;
+    // update_branch_cost calls, vertices whose cost they changed and the
+    // deepest of those below the vertex the update started at
+    size_t cost_updates, cost_updated_vertices, max_cost_depth;
+    // seconds on the steady clock
+    double sample_time, near_time, parent_time, rewire_time, iteration_time;
+
+    rrts_stats_t()
+    {
+        reset();
+    }
+    void reset()
+    {
+        iterations = added_vertices = 0;
+        samples = rejected_samples = 0;
+        near_queries = near_vertices = max_near_vertices = 0;
+        steering_evaluations = collision_checks = rewires = 0;
+        cost_updates = cost_updated_vertices = max_cost_depth = 0;
+        sample_time = near_time = parent_time = rewire_time = iteration_time = 0;
+    }
+
+    void add_near_query(size_t n)
+    {
+        near_queries++;
+        near_vertices += n;
+        if(n > max_near_vertices)
+            max_near_vertices = n;
+    }
+    void add_cost_depth(size_t depth)
+    {
+        cost_updated_vertices++;
+        if(depth > max_cost_depth)
+            max_cost_depth = depth;
+    }
+
+    double collision_checks_per_edge() const
+    {
+        size_t edges = added_vertices + rewires;
+        return edges ? collision_checks/(double)edges : 0;
+    }
+
+    void print(ostream& os=cout) const
+    {
+        os<<"iterations: "<< iterations <<" added: "<< added_vertices << endl;
+        os<<"samples: "<< samples <<" rejected: "<< rejected_samples
+            <<" time: "<< sample_time << endl;
+        os<<"near queries: "<< near_queries <<" mean size: "
+            << (near_queries ? near_vertices/(double)near_queries : 0)
+            <<" max size: "<< max_near_vertices <<" time: "<< near_time << endl;
+        os<<"steering: "<< steering_evaluations <<" collision checks: "<< collision_checks
+            <<" per edge: "<< collision_checks_per_edge() <<" parent time: "<< parent_time << endl;
+        os<<"rewires: "<< rewires <<" time: "<< rewire_time << endl;
+        os<<"cost updates: "<< cost_updates <<" vertices: "<< cost_updated_vertices
+            <<" max depth: "<< max_cost_depth << endl;
+        os<<"iteration time: "<< iteration_time << endl;
+    }
+};
+
+// adds the time until it goes out of scope to total
+class stats_timer_c
+{
+    public:
+        typedef chrono::steady_clock clock_type;
+
+        stats_timer_c(double& total_in) : total(total_in), t0(clock_type::now()) {}
+        ~stats_timer_c()
+        {
+            total += chrono::duration<double>(clock_type::now() - t0).count();
+        }
+
+    protected:
+        double& total;
+        clock_type::time_point t0;
+};
+
+#endif
@@ -3,12 +3,15 @@
 
 #include "dynamical_system.h"
 #include "map.h"
+#include "stats.h"
 #include <cmath>
 #include <cfloat>
 #include <vector>
+#include <array>
 #include <ostream>
 #include <string.h>
 #include <cstdlib>
+#include <algorithm>
 using namespace std;
 
 
@@ -155,6 +158,83 @@ class cost_c
         }
 };
 
+/*
+ * Drop-in replacement for cost_c with the same interface and the same
+ * lexicographic operator< (which is <=). The values are held in a
+ * std::array and no member is virtual, so a cost is trivially copyable,
+ * stored inline in vertices, edges and queue entries, and copied without
+ * an allocation. Pick it through the cost_tt argument of system_c, e.g.
+ * system_c<dynamics_t, map_t, region_t, fixed_cost_c<1> >.
+ */
+template<size_t dim_t>
+class fixed_cost_c
+{
+    public:
+        const static size_t dim = dim_t;
+        array<double, dim_t> val;
+
+        fixed_cost_c(double x=FLT_MAX/2){
+            val.fill(x);
+        }
+        fixed_cost_c(double c, int d){
+            val.fill(FLT_MAX/2);
+            val[d] = c;
+        }
+
+        double& operator[](int d){
+            return val[d];
+        }
+        const double& operator[](int d) const{
+            return val[d];
+        }
+        fixed_cost_c& operator+=(const fixed_cost_c& rhs)
+        {
+            for(size_t i=0; i<dim_t; i++)
+                val[i] += rhs.val[i];
+            return *this;
+        }
+        fixed_cost_c operator+(const fixed_cost_c& c2) const
+        {
+            fixed_cost_c toret = *this;
+            toret += c2;
+            return toret;
+        }
+        constexpr bool operator<(const fixed_cost_c& rhs) const
+        {
+            return less_equal(rhs, 0);
+        }
+        constexpr bool operator>(const fixed_cost_c& rhs) const
+        {
+            return !less_equal(rhs, 0);
+        }
+        double difference(const fixed_cost_c& c2) const
+        {
+            double t1 = 0;
+            for(size_t i=0; i<dim_t; i++)
+                t1 += (val[i]-c2.val[i])*(val[i]-c2.val[i]);
+            return sqrt(t1);
+        }
+        ostream& print(ostream& os=cout, const char* prefix=NULL, const char* suffix=NULL) const
+        {
+            if(prefix)
+                os<<prefix;
+            for(auto& vi : val)
+                os<<vi<<",";
+            if(suffix)
+                os<<suffix;
+            return os;
+        }
+
+    protected:
+        // single return statements, constexpr under C++11
+        constexpr bool less_equal(const fixed_cost_c& rhs, size_t i) const
+        {
+            return (i == dim_t) ? true :
+                (val[i] < rhs.val[i]) ? true :
+                (val[i] > rhs.val[i]) ? false : less_equal(rhs, i+1);
+        }
+};
+
 
 template<class dynamical_system_tt, class map_tt, class region_tt, class cost_tt>
 class system_c
@@ -174,16 +254,64 @@ class system_c
         map_t obstacle_map;
         dynamical_system_t dynamical_system;
 
+        // all sampling of the planner goes through rng, seed it for replays
+        random_c rng;
+
         region_t operating_region;
         region_t goal_region;
         vector<region_t> heuristic_sampling_regions;
         double heuristic_sampling_probability;
 
+        // strided: every collision_check_stride-th state of a trajectory
+        // adaptive: bisects the trajectory and skips the states within the
+        //      clearance reported by the map, checks every other state.
+        //      Distances along the trajectory are measured in all
+        //      coordinates, or only in x,y if clearance_only_xy is set.
+        enum collision_check_mode_t {strided_collision_check=0, adaptive_collision_check};
+        collision_check_mode_t collision_check_mode;
+        size_t collision_check_stride;
+        bool clearance_only_xy;
+
+        // informed sampling: once the planner has reported a solution of
+        // informed_cost from informed_start, sample_state only returns
+        // states s with
+        //     lower_bound(informed_start, s) + distance(s, goal region) < informed_cost
+        // where lower_bound is dynamical_system.evaluate_cost_lower_bound and
+        // distance is taken in the first d = get_euclidean_bound_dim()
+        // coordinates. Those coordinates are drawn from the prolate
+        // hyperspheroid with foci informed_start and the goal center and
+        // transverse diameter informed_cost plus the half-diagonal of the
+        // goal region, the others uniformly. After max_informed_attempts
+        // rejected draws, or if the hyperspheroid is degenerate, it samples
+        // uniformly.
+        bool use_informed_sampling;
+        size_t max_informed_attempts;
+        state informed_start;
+        double informed_cost;
+        size_t num_informed_draws, num_informed_accepted;
+
         system_c(){
             heuristic_sampling_probability = 0.5;
+            collision_check_mode = strided_collision_check;
+            collision_check_stride = 10;
+            clearance_only_xy = false;
+            use_informed_sampling = false;
+            max_informed_attempts = 100;
+            informed_cost = FLT_MAX/2;
+            num_informed_draws = num_informed_accepted = 0;
         };
         ~system_c(){}
 
+        // draws sample_state and sample_in_goal threw away on the calling
+        // thread, counted with SMPL_STATS only. The workers of
+        // parallel_rrts_c share the system, so the count is per thread and
+        // callers read it before and after sampling.
+        static size_t& num_rejected_samples()
+        {
+            static thread_local size_t n = 0;
+            return n;
+        }
+
         virtual int get_key(const state& s, double* key)
         {
             for(size_t i=0; i<N; i++)
@@ -220,6 +348,10 @@ class system_c
         }
 
         virtual int sample_state(state& s, bool sample_from_free=false)
+        {
+            return sample_state(s, rng, sample_from_free);
+        }
+        virtual int sample_state(state& s, random_c& rng_in, bool sample_from_free=false)
         {
             if(sample_from_free)
             {
@@ -228,10 +360,13 @@ class system_c
             }
             else
             {
+                if(is_informed() && !sample_informed(s, rng_in))
+                    return 0;
+
                 bool found_free_state = false;
                 while(!found_free_state)
                 {
-                    double p = RANDF;
+                    double p = rng_in.uniform();
                     region_t* r = &operating_region;
                     if(heuristic_sampling_regions.size())
                     {
@@ -239,25 +374,150 @@ class system_c
                             r = &operating_region;
                         else
                         {
-                            int which = RANDF*heuristic_sampling_regions.size();
+                            int which = rng_in.uniform_int(heuristic_sampling_regions.size());
                             r = &(heuristic_sampling_regions[which]);
                         }
                     }
 
-                    dynamical_system.sample_state(r->c, r->s, s.x);
+                    dynamical_system.sample_state(r->c, r->s, s.x, rng_in);
                     found_free_state = !is_in_collision(s);
+                    SMPL_STAT(num_rejected_samples() += !found_free_state);
                 }
             }
             return 0;
         }
+        int set_informed_cost(const state& start, double cost)
+        {
+            informed_start = start;
+            informed_cost = cost;
+            num_informed_draws = num_informed_accepted = 0;
+            return 0;
+        }
+        bool is_informed() const
+        {
+            return use_informed_sampling && (informed_cost < FLT_MAX/4);
+        }
+        bool can_improve_informed_cost(const state& s)
+        {
+            const size_t d = min(dynamical_system.get_euclidean_bound_dim(), (size_t)N);
+            double to_goal = 0;
+            for(size_t i=0; i<d; i++)
+                to_goal += SQ(max(fabs(s.x[i] - goal_region.c[i]) - goal_region.s[i]/2, 0.0));
+            return dynamical_system.evaluate_cost_lower_bound(informed_start, s)
+                + sqrt(to_goal) < informed_cost;
+        }
+
+        // distance between the foci and transverse diameter of the
+        // hyperspheroid in the first d coordinates, false if it is
+        // degenerate
+        bool get_informed_axes(size_t d, double& c_min, double& c_max)
+        {
+            double h = 0;
+            c_min = 0;
+            for(size_t i=0; i<d; i++)
+            {
+                c_min += SQ(goal_region.c[i] - informed_start.x[i]);
+                h += SQ(goal_region.s[i]/2);
+            }
+            c_min = sqrt(c_min);
+            c_max = informed_cost + sqrt(h);
+            return c_max > c_min;
+        }
+
+        // estimate of the fraction of the operating region that can improve
+        // informed_cost: the volume of the prolate hyperspheroid over that of
+        // the region in the first get_euclidean_bound_dim() coordinates,
+        // times the share of draws sample_informed accepted. The planners
+        // shrink their connection radius by it.
+        double get_informed_volume_fraction()
+        {
+            const size_t d = min(dynamical_system.get_euclidean_bound_dim(), (size_t)N);
+            if(!is_informed())
+                return 1;
+            double accepted = (num_informed_accepted + 1.0)/(num_informed_draws + 1.0);
+            if(!d)
+                return accepted;
+            double c_min, c_max;
+            if(!get_informed_axes(d, c_min, c_max))
+                return 1;
+            double r2 = sqrt(SQ(c_max) - SQ(c_min))/2;
+            double v = pow(M_PI, d/2.0)/tgamma(d/2.0 + 1)*c_max/2*pow(r2, d-1.0);
+            for(size_t i=0; i<d; i++)
+                v /= operating_region.s[i];
+            return min(v, 1.0)*accepted;
+        }
+
+        // returns 1 if max_informed_attempts draws were rejected or the
+        // hyperspheroid is degenerate
+        int sample_informed(state& s, random_c& rng_in)
+        {
+            const size_t d = min(dynamical_system.get_euclidean_bound_dim(), (size_t)N);
+            double c_min = 0, c_max = 0;
+            if(d && !get_informed_axes(d, c_min, c_max))
+                return 1;
+
+            // the reflection I - 2 v v'/|v|^2 maps e1 to the axis a1 of the foci
+            double center[N], v[N];
+            double vv = 0;
+            for(size_t i=0; i<d; i++)
+            {
+                center[i] = (informed_start.x[i] + goal_region.c[i])/2;
+                double a1 = (c_min > 1e-9) ? (goal_region.c[i] - informed_start.x[i])/c_min : (i == 0);
+                v[i] = (i == 0) - a1;
+                vv += SQ(v[i]);
+            }
+            double r1 = c_max/2;
+            double r2 = sqrt(max(SQ(c_max) - SQ(c_min), 0.0))/2;
+
+            double b[N];
+            for(size_t k=0; k<max_informed_attempts; k++)
+            {
+                num_informed_draws++;
+                dynamical_system.sample_state(operating_region.c, operating_region.s, s.x, rng_in);
+                if(d)
+                {
+                    // uniform in the unit ball, scaled to the radii
+                    double bn = 0;
+                    for(size_t i=0; i<d; i++)
+                    {
+                        b[i] = rng_in.normal();
+                        bn += SQ(b[i]);
+                    }
+                    double scale = pow(rng_in.uniform(), 1.0/d)/sqrt(bn);
+                    double vb = 0;
+                    for(size_t i=0; i<d; i++)
+                    {
+                        b[i] *= scale*(i ? r2 : r1);
+                        vb += v[i]*b[i];
+                    }
+                    for(size_t i=0; i<d; i++)
+                        s.x[i] = center[i] + b[i] - ((vv > 1e-12) ? 2*vb/vv*v[i] : 0);
+                }
+                if(operating_region.is_inside(s) && can_improve_informed_cost(s)
+                        && !is_in_collision(s))
+                {
+                    num_informed_accepted++;
+                    return 0;
+                }
+                SMPL_STAT(num_rejected_samples()++);
+            }
+            return 1;
+        }
+
         virtual int sample_in_goal(state& s)
+        {
+            return sample_in_goal(s, rng);
+        }
+        virtual int sample_in_goal(state& s, random_c& rng_in)
         {
             bool found_free_state = false;
             while(!found_free_state)
             {
+                rng_in.uniform(s.x, N);
                 for(size_t i=0; i<N; i++)
-                    s.x[i] = goal_region.c[i] + (RANDF-0.5)*goal_region.s[i];
+                    s.x[i] = goal_region.c[i] + (s.x[i]-0.5)*goal_region.s[i];
                 found_free_state = !is_in_collision(s);
+                SMPL_STAT(num_rejected_samples() += !found_free_state);
             }
             return 0;
         }
@@ -267,20 +527,80 @@ class system_c
             memcpy(xout, xin, sizeof(double)*dim);
             return 0;
         }
+        // checks every collision_check_stride-th state, handing them to the
+        // map in batches
         virtual bool is_safe_trajectory(const trajectory& traj)
         {
             if(traj.states.empty())
                 return true;
+            if(collision_check_mode == adaptive_collision_check)
+                return is_safe_trajectory_adaptive(traj);
 
-            int drop_counter=0;
-            for(auto& s : traj.states)
+            const size_t stride = max(collision_check_stride, (size_t)1), batch_size = 64;
+            static thread_local vector<double> batch_states(N*batch_size);
+            static thread_local vector<uint8_t> batch_out(batch_size);
+
+            size_t num_checked = (traj.states.size() + stride - 1)/stride;
+            for(size_t b=0; b<num_checked; b+=batch_size)
             {
-                if(drop_counter %10 == 0)
+                size_t count = min(batch_size, num_checked-b);
+                for(size_t i=0; i<count; i++)
+                {
+                    const state& s = traj.states[(b+i)*stride];
+                    if(!operating_region.is_inside(s, true))
+                        return false;
+                    for(size_t d=0; d<N; d++)
+                        batch_states[d*count + i] = s.x[d];
+                }
+                obstacle_map.is_in_collision_batch(&batch_states[0], count, &batch_out[0]);
+                for(size_t i=0; i<count; i++)
                 {
-                    if(is_in_collision(s))
+                    if(batch_out[i])
                         return false;
                 }
-                drop_counter++;
+            }
+            return true;
+        }
+
+        bool is_safe_trajectory_adaptive(const trajectory& traj)
+        {
+            const vector<state>& states = traj.states;
+            size_t n = states.size();
+            static thread_local vector<double> arclength;
+            static thread_local vector<pair<size_t, size_t> > intervals;
+
+            arclength.resize(n);
+            for(size_t i=0; i<n; i++)
+            {
+                if(!operating_region.is_inside(states[i], true))
+                    return false;
+                arclength[i] = i ? arclength[i-1] + states[i].dist(states[i-1], clearance_only_xy) : 0;
+            }
+
+            // breadth-first over the unverified intervals, so the middle of
+            // the trajectory is checked before its ends
+            intervals.clear();
+            intervals.push_back(make_pair((size_t)0, n-1));
+            for(size_t k=0; k<intervals.size(); k++)
+            {
+                size_t a = intervals[k].first, b = intervals[k].second;
+                size_t m = (a+b)/2;
+                size_t lo = m, hi = m;
+                double c = obstacle_map.get_clearance(states[m].x);
+                if(c > 0)
+                {
+                    lo = upper_bound(arclength.begin()+a, arclength.begin()+m,
+                            arclength[m] - c) - arclength.begin();
+                    hi = lower_bound(arclength.begin()+m, arclength.begin()+b+1,
+                            arclength[m] + c) - arclength.begin() - 1;
+                }
+                else if(obstacle_map.is_in_collision(states[m].x))
+                    return false;
+
+                if(lo > a)
+                    intervals.push_back(make_pair(a, lo-1));
+                if(hi < b)
+                    intervals.push_back(make_pair(hi+1, b));
             }
             return true;
         }
@@ -307,6 +627,49 @@ class system_c
             return res;
         }
 
+        // same answer as extend_to(si, sf, true, ..) == 0 for callers that
+        // do not need the trajectory. In the strided mode the states are
+        // streamed from the dynamical system into the map and the
+        // steering stops at the first collision.
+        virtual bool is_feasible(const state& si, const state& sf, opt_data_t& opt_data)
+        {
+            if(collision_check_mode == adaptive_collision_check)
+            {
+                trajectory traj;
+                return !extend_to(si, sf, true, traj, opt_data);
+            }
+            const size_t stride = max(collision_check_stride, (size_t)1);
+            return !dynamical_system.steer(si, sf, opt_data, stride,
+                    [this](const double* states, size_t count)
+                    {
+                        return is_safe_states(states, count) ? 0 : 1;
+                    });
+        }
+
+        // state i at states[i*N .. i*N+N)
+        bool is_safe_states(const double* states, size_t count)
+        {
+            static thread_local vector<double> batch_states;
+            static thread_local vector<uint8_t> batch_out;
+            batch_states.resize(N*count);
+            batch_out.resize(count);
+            for(size_t i=0; i<count; i++)
+            {
+                state s(states + i*N);
+                if(!operating_region.is_inside(s, true))
+                    return false;
+                for(size_t d=0; d<N; d++)
+                    batch_states[d*count + i] = s.x[d];
+            }
+            obstacle_map.is_in_collision_batch(&batch_states[0], count, &batch_out[0]);
+            for(size_t i=0; i<count; i++)
+            {
+                if(batch_out[i])
+                    return false;
+            }
+            return true;
+        }
+
         virtual int evaluate_extend_cost(const state& si, const state& sf,
                 opt_data_t& opt_data, cost_t& extend_cost)
         {
@@ -317,6 +680,16 @@ class system_c
             extend_cost[extend_cost.dim-1] = total_variation;
             return 0;
         }
+        // also returns the dt of the edge from dynamical_system, after the
+        // cost has filled opt_data
+        int evaluate_extend_cost(const state& si, const state& sf,
+                opt_data_t& opt_data, cost_t& extend_cost, double& duration)
+        {
+            if(evaluate_extend_cost(si, sf, opt_data, extend_cost))
+                return 1;
+            duration = dynamical_system.evaluate_extend_duration(si, sf, opt_data);
+            return duration < 0;
+        }
 
         virtual cost_t get_state_cost(const state& s)
         {
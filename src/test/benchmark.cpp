@@ -0,0 +1,503 @@
+/*
+ * Headless benchmark of rrts_c and brrts_c on every dynamical system of the
+ * library and a few standard obstacle scenarios. Every run is forked into
+ * its own process, so its peak memory is its own and a run that hangs or
+ * crashes is reported instead of taking the suite down. Runs are seeded
+ * with 1..seeds; with --iterations and no --time they are bit-identical
+ * across invocations.
+ *
+ *   benchmark [--time s] [--iterations n] [--seeds n] [--timeout s]
+ *             [--systems si,dubins,dint,dubins_velocity,reeds_shepp]
+ *             [--planners rrts,brrts] [--scenarios empty,boxes,wall]
+ *             [--csv prefix] [--json file]
+ *
+ * One summary row per run goes to stdout as CSV. --csv writes it to
+ * <prefix>_runs.csv and the cost-vs-time curves, one point per
+ * improvement of the best cost, to <prefix>_curves.csv. --json writes
+ * both into one file.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "../single_integrator.h"
+#include "../dubins.h"
+#include "../double_integrator.h"
+#include "../dubins_velocity.h"
+#include "../reeds_shepp.h"
+#include "../box_map.h"
+#include "../rrts.h"
+#include "../brrts.h"
+using namespace std;
+
+struct options_t
+{
+    double time_budget;
+    long max_iterations;
+    int num_seeds;
+    int timeout;
+    string systems, planners, scenarios;
+    string csv_prefix, json_file;
+
+    options_t() : time_budget(1), max_iterations(0), num_seeds(3), timeout(60),
+        systems("si,dubins,dint,dubins_velocity,reeds_shepp"), planners("rrts,brrts"),
+        scenarios("empty,boxes,wall") {}
+};
+
+struct curve_point_t
+{
+    double time;
+    long iteration;
+    double cost;
+    long vertices;
+};
+
+// written by the child process into a pipe, status is set by the parent
+struct run_result_t
+{
+    double time;
+    long iterations;
+    long vertices;
+    double first_solution_time;
+    long first_solution_iteration;
+    double first_cost;
+    double final_cost;
+    long peak_rss_kb;
+    long base_rss_kb;
+    int num_points;
+};
+
+struct run_t
+{
+    string system, planner, scenario;
+    int seed;
+    string status;
+    run_result_t result;
+    vector<curve_point_t> curve;
+};
+
+/*
+ * Obstacles are boxes over x, y given as fractions of the extent of the
+ * operating region. The start is its center, the goal at (0.3, 0.2).
+ */
+struct scenario_t
+{
+    string name;
+    vector<double> boxes;   // cx, cy, sx, sy
+};
+
+vector<scenario_t> get_scenarios()
+{
+    vector<scenario_t> s(3);
+    s[0].name = "empty";
+    // one box on the straight line to the goal and three around it
+    s[1].name = "boxes";
+    s[1].boxes = {0.15,0.1,0.08,0.08,  0.25,-0.1,0.1,0.1,  -0.1,0.25,0.1,0.1,  0.05,0.35,0.1,0.1};
+    // a wall across the region with a passage 0.08 wide at y=0.34. It is
+    // thicker than the spacing of the states the collision checker looks at.
+    s[2].name = "wall";
+    s[2].boxes = {0.15,-0.1,0.1,0.8,  0.15,0.44,0.1,0.12};
+    return s;
+}
+
+template<class system_t>
+void setup_system(system_t& system, const double* center, const double* size,
+        const double* goal, const double* goal_size, const scenario_t& scenario)
+{
+    system.operating_region = typename system_t::region_t(center, size);
+    system.goal_region = typename system_t::region_t(goal, goal_size);
+    system.obstacle_map.clear();
+    for(size_t i=0; i+3<scenario.boxes.size(); i+=4)
+    {
+        double c[2] = {scenario.boxes[i]*size[0], scenario.boxes[i+1]*size[1]};
+        double s[2] = {scenario.boxes[i+2]*size[0], scenario.boxes[i+3]*size[1]};
+        system.obstacle_map.add_box(c, s);
+    }
+}
+
+/*
+ * Regions of every system, the goal is at (0.3, 0.2) of the xy extent.
+ */
+typedef system_c<single_integrator_c<2>, box_map_c<2,2>, region_c<2>, cost_c<1> > si_t;
+typedef system_c<dubins_c, box_map_c<3,2>, region_c<3>, cost_c<1> > dubins_t;
+typedef system_c<double_integrator_c, box_map_c<4,2>, region_c<4>, cost_c<1> > dint_t;
+typedef system_c<dubins_velocity_c, box_map_c<4,2>, region_c<4>, cost_c<1> > dubins_velocity_t;
+typedef system_c<reeds_shepp_c, box_map_c<3,2>, region_c<3>, cost_c<1> > reeds_shepp_t;
+
+void setup(si_t& s, const scenario_t& sc)
+{
+    double c[2] = {0,0}, sz[2] = {50,50}, g[2] = {15,10}, gs[2] = {2,2};
+    setup_system(s, c, sz, g, gs, sc);
+}
+void setup(dubins_t& s, const scenario_t& sc)
+{
+    double c[3] = {0,0,0}, sz[3] = {100,100,2*M_PI}, g[3] = {30,20,M_PI/2}, gs[3] = {4,4,0.2*M_PI};
+    setup_system(s, c, sz, g, gs, sc);
+}
+void setup(dint_t& s, const scenario_t& sc)
+{
+    double c[4] = {0,0,0,0}, sz[4] = {25,25,5,5}, g[4] = {7.5,5,0,0}, gs[4] = {1,1,1,1};
+    setup_system(s, c, sz, g, gs, sc);
+}
+void setup(dubins_velocity_t& s, const scenario_t& sc)
+{
+    double c[4] = {0,0,0,0}, sz[4] = {25,25,2*M_PI,5}, g[4] = {7.5,5,0,1}, gs[4] = {1,1,0.2*M_PI,0.5};
+    setup_system(s, c, sz, g, gs, sc);
+}
+void setup(reeds_shepp_t& s, const scenario_t& sc)
+{
+    double c[3] = {0,0,0}, sz[3] = {25,25,2*M_PI}, g[3] = {7.5,5,0}, gs[3] = {1,1,0.2*M_PI};
+    setup_system(s, c, sz, g, gs, sc);
+}
+
+template<class V, class E, class K>
+bool has_solution(rrts_c<V,E,K>& p)
+{
+    return p.lower_bound_vertex != NULL;
+}
+template<class V, class E, class K>
+bool has_solution(brrts_c<V,E,K>& p)
+{
+    return p.lower_bound_bvertex != NULL;
+}
+
+long get_rss_kb()
+{
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if(!f)
+        return 0;
+    if(fscanf(f, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    fclose(f);
+    return resident*(sysconf(_SC_PAGESIZE)/1024);
+}
+
+template<class planner_t>
+void run_planner(const scenario_t& scenario, int seed, const options_t& opt,
+        run_result_t& res, vector<curve_point_t>& curve)
+{
+    typedef typename planner_t::system_t system_t;
+    typedef typename system_t::state state;
+    typedef chrono::steady_clock clock_t;
+
+    res.base_rss_kb = get_rss_kb();
+    planner_t* planner = new planner_t();
+    setup(planner->system, scenario);
+    planner->system.rng.seed(seed);
+    double zero[system_t::N] = {0};
+    planner->initialize(state(zero));
+
+    res.first_solution_time = -1;
+    res.first_solution_iteration = -1;
+    res.first_cost = -1;
+    double best = -1;
+
+    clock_t::time_point start = clock_t::now();
+    double t = 0;
+    long i = 0;
+    while(true)
+    {
+        if(opt.max_iterations && (i >= opt.max_iterations))
+            break;
+        if((opt.time_budget > 0) && (t >= opt.time_budget))
+            break;
+        planner->iteration();
+        i++;
+        t = chrono::duration<double>(clock_t::now() - start).count();
+
+        if(!has_solution(*planner))
+            continue;
+        double c = planner->get_best_cost().val[0];
+        if((best >= 0) && (c >= best))
+            continue;
+        if(best < 0)
+        {
+            res.first_solution_time = t;
+            res.first_solution_iteration = i;
+            res.first_cost = c;
+        }
+        best = c;
+        curve_point_t p = {t, i, c, (long)planner->num_vertices};
+        curve.push_back(p);
+    }
+    res.time = t;
+    res.iterations = i;
+    res.vertices = planner->num_vertices;
+    res.final_cost = best;
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    res.peak_rss_kb = ru.ru_maxrss;
+    // the tree is not freed, the process exits right after
+}
+
+typedef function<void(const scenario_t&, int, const options_t&, run_result_t&, vector<curve_point_t>&)> runner_t;
+
+struct case_t
+{
+    string system, planner;
+    runner_t run;
+};
+
+template<class system_t>
+void add_cases(vector<case_t>& cases, const string& name)
+{
+    case_t c;
+    c.system = name;
+    c.planner = "rrts";
+    c.run = run_planner<rrts_c<vertex_c<system_t>, edge_c<system_t> > >;
+    cases.push_back(c);
+    c.planner = "brrts";
+    c.run = run_planner<brrts_c<bvertex_c<system_t>, bedge_c<system_t> > >;
+    cases.push_back(c);
+}
+
+bool selected(const string& list, const string& name)
+{
+    stringstream ss(list);
+    string item;
+    while(getline(ss, item, ','))
+    {
+        if(item == name)
+            return true;
+    }
+    return false;
+}
+
+bool write_all(int fd, const void* buf, size_t n)
+{
+    const char* p = (const char*)buf;
+    while(n)
+    {
+        ssize_t w = write(fd, p, n);
+        if(w <= 0)
+            return false;
+        p += w;
+        n -= w;
+    }
+    return true;
+}
+bool read_all(int fd, void* buf, size_t n)
+{
+    char* p = (char*)buf;
+    while(n)
+    {
+        ssize_t r = read(fd, p, n);
+        if(r <= 0)
+            return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+// forks, runs the case in the child and collects its result
+int run_forked(const case_t& c, const scenario_t& scenario, int seed, const options_t& opt, run_t& run)
+{
+    memset(&run.result, 0, sizeof(run.result));
+    int fds[2];
+    if(pipe(fds))
+        return 1;
+    fflush(stdout);
+    cout.flush();
+    pid_t pid = fork();
+    if(pid < 0)
+        return 1;
+    if(pid == 0)
+    {
+        close(fds[0]);
+        // the planners print to cout, keep stdout for the results
+        if(FILE* f = freopen("/dev/null", "w", stdout))
+            (void)f;
+        alarm(opt.timeout);
+        run_result_t res;
+        memset(&res, 0, sizeof(res));
+        vector<curve_point_t> curve;
+        c.run(scenario, seed, opt, res, curve);
+        res.num_points = curve.size();
+        bool ok = write_all(fds[1], &res, sizeof(res));
+        if(ok && !curve.empty())
+            ok = write_all(fds[1], &curve[0], curve.size()*sizeof(curve_point_t));
+        _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    bool ok = read_all(fds[0], &run.result, sizeof(run.result));
+    if(ok && (run.result.num_points > 0))
+    {
+        run.curve.resize(run.result.num_points);
+        ok = read_all(fds[0], &run.curve[0], run.curve.size()*sizeof(curve_point_t));
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    if(WIFSIGNALED(status))
+        run.status = (WTERMSIG(status) == SIGALRM) ? "timeout" : "crashed";
+    else if(!ok || WEXITSTATUS(status))
+        run.status = "failed";
+    else
+        run.status = "ok";
+    if(run.status != "ok")
+        run.curve.clear();
+    return 0;
+}
+
+const char* runs_header = "system,planner,scenario,seed,status,iterations,time_s,iterations_per_s,"
+    "vertices,first_solution_s,first_solution_iteration,first_cost,final_cost,peak_rss_kb,base_rss_kb";
+
+void write_run_csv(ostream& os, const run_t& r)
+{
+    const run_result_t& s = r.result;
+    os<<r.system<<","<<r.planner<<","<<r.scenario<<","<<r.seed<<","<<r.status<<","
+        <<s.iterations<<","<<s.time<<","<<(s.time > 0 ? s.iterations/s.time : 0)<<","
+        <<s.vertices<<","<<s.first_solution_time<<","<<s.first_solution_iteration<<","
+        <<s.first_cost<<","<<s.final_cost<<","<<s.peak_rss_kb<<","<<s.base_rss_kb<<endl;
+}
+
+void write_csv(const string& prefix, const vector<run_t>& runs)
+{
+    ofstream fr((prefix + "_runs.csv").c_str());
+    fr<<runs_header<<endl;
+    for(auto& r : runs)
+        write_run_csv(fr, r);
+
+    ofstream fc((prefix + "_curves.csv").c_str());
+    fc<<"system,planner,scenario,seed,time_s,iteration,cost,vertices"<<endl;
+    for(auto& r : runs)
+    {
+        for(auto& p : r.curve)
+            fc<<r.system<<","<<r.planner<<","<<r.scenario<<","<<r.seed<<","
+                <<p.time<<","<<p.iteration<<","<<p.cost<<","<<p.vertices<<endl;
+    }
+}
+
+void write_json(const string& file, const options_t& opt, const vector<run_t>& runs)
+{
+    ofstream f(file.c_str());
+    f<<"{\n  \"time_budget_s\": "<<opt.time_budget<<",\n  \"max_iterations\": "<<opt.max_iterations
+        <<",\n  \"runs\": [";
+    for(size_t i=0; i<runs.size(); i++)
+    {
+        const run_t& r = runs[i];
+        const run_result_t& s = r.result;
+        f<<(i ? ",\n" : "\n")<<"    {\"system\": \""<<r.system<<"\", \"planner\": \""<<r.planner
+            <<"\", \"scenario\": \""<<r.scenario<<"\", \"seed\": "<<r.seed
+            <<", \"status\": \""<<r.status<<"\", \"iterations\": "<<s.iterations
+            <<", \"time_s\": "<<s.time<<", \"iterations_per_s\": "<<(s.time > 0 ? s.iterations/s.time : 0)
+            <<", \"vertices\": "<<s.vertices<<", \"first_solution_s\": "<<s.first_solution_time
+            <<", \"first_solution_iteration\": "<<s.first_solution_iteration
+            <<", \"first_cost\": "<<s.first_cost<<", \"final_cost\": "<<s.final_cost
+            <<", \"peak_rss_kb\": "<<s.peak_rss_kb<<", \"base_rss_kb\": "<<s.base_rss_kb
+            <<",\n     \"curve\": [";
+        for(size_t j=0; j<r.curve.size(); j++)
+        {
+            const curve_point_t& p = r.curve[j];
+            f<<(j ? ", " : "")<<"["<<p.time<<", "<<p.iteration<<", "<<p.cost<<", "<<p.vertices<<"]";
+        }
+        f<<"]}";
+    }
+    f<<"\n  ]\n}\n";
+}
+
+int parse_options(int argc, char** argv, options_t& opt)
+{
+    for(int i=1; i<argc; i++)
+    {
+        string a = argv[i];
+        if(i+1 >= argc)
+            return 1;
+        string v = argv[++i];
+        if(a == "--time")
+            opt.time_budget = atof(v.c_str());
+        else if(a == "--iterations")
+            opt.max_iterations = atol(v.c_str());
+        else if(a == "--seeds")
+            opt.num_seeds = atoi(v.c_str());
+        else if(a == "--timeout")
+            opt.timeout = atoi(v.c_str());
+        else if(a == "--systems")
+            opt.systems = v;
+        else if(a == "--planners")
+            opt.planners = v;
+        else if(a == "--scenarios")
+            opt.scenarios = v;
+        else if(a == "--csv")
+            opt.csv_prefix = v;
+        else if(a == "--json")
+            opt.json_file = v;
+        else
+            return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    options_t opt;
+    // --iterations alone runs without a time limit
+    for(int i=1; i<argc; i++)
+    {
+        if(string(argv[i]) == "--iterations")
+            opt.time_budget = 0;
+    }
+    if(parse_options(argc, argv, opt) || ((opt.time_budget <= 0) && (opt.max_iterations <= 0)))
+    {
+        cerr<<"usage: "<<argv[0]<<" [--time s] [--iterations n] [--seeds n] [--timeout s]"
+            <<" [--systems list] [--planners list] [--scenarios list] [--csv prefix] [--json file]"<<endl;
+        return 1;
+    }
+
+    vector<case_t> cases;
+    add_cases<si_t>(cases, "si");
+    add_cases<dubins_t>(cases, "dubins");
+    add_cases<dint_t>(cases, "dint");
+    add_cases<dubins_velocity_t>(cases, "dubins_velocity");
+    add_cases<reeds_shepp_t>(cases, "reeds_shepp");
+    vector<scenario_t> scenarios = get_scenarios();
+
+    vector<run_t> runs;
+    cout<<runs_header<<endl;
+    for(auto& c : cases)
+    {
+        if(!selected(opt.systems, c.system) || !selected(opt.planners, c.planner))
+            continue;
+        for(auto& sc : scenarios)
+        {
+            if(!selected(opt.scenarios, sc.name))
+                continue;
+            for(int seed=1; seed<=opt.num_seeds; seed++)
+            {
+                run_t r;
+                r.system = c.system;
+                r.planner = c.planner;
+                r.scenario = sc.name;
+                r.seed = seed;
+                if(run_forked(c, sc, seed, opt, r))
+                {
+                    cerr<<"could not fork"<<endl;
+                    return 1;
+                }
+                write_run_csv(cout, r);
+                runs.push_back(r);
+            }
+        }
+    }
+
+    if(!opt.csv_prefix.empty())
+        write_csv(opt.csv_prefix, runs);
+    if(!opt.json_file.empty())
+        write_json(opt.json_file, opt, runs);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <vector>
+
+#include "../utils.h"
+#include "../random.h"
+#include "../box_map.h"
+#include "../system.h"
+#include "../single_integrator.h"
+#include "../dubins.h"
+using namespace std;
+
+const size_t N = 3;
+typedef box_map_c<N, 2> map_t;
+
+int test_batch(int num_boxes, int count)
+{
+    random_c rng(1);
+    map_t map;
+    for(int b=0; b<num_boxes; b++)
+    {
+        double c[2] = {rng.uniform(-50, 50), rng.uniform(-50, 50)};
+        double s[2] = {rng.uniform(1, 10), rng.uniform(1, 10)};
+        map.add_box(c, s);
+    }
+
+    vector<double> states(N*count);
+    for(int d=0; d<(int)N; d++)
+    {
+        for(int i=0; i<count; i++)
+            states[d*count + i] = rng.uniform(-55, 55);
+    }
+    vector<uint8_t> out(count);
+    map.is_in_collision_batch(&states[0], count, &out[0]);
+
+    int errors = 0, num_collisions = 0;
+    for(int i=0; i<count; i++)
+    {
+        double s[N];
+        for(size_t d=0; d<N; d++)
+            s[d] = states[d*count + i];
+        if((bool)out[i] != map.is_in_collision(s))
+            errors++;
+        num_collisions += out[i];
+    }
+    cout<<"boxes: "<< num_boxes <<" states: "<< count <<" in collision: "<< num_collisions
+        <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// adaptive collision checking skips the states within the clearance of
+// the map, it has to agree with checking every state of the edge. The
+// boxes are thinner than the stride between checked states.
+template<class system_t>
+int test_adaptive(const char* name, bool clearance_only_xy, int count)
+{
+    system_t system;
+    random_c rng(3);
+    double oc[3] = {0, 0, M_PI}, os[3] = {200, 200, 2*M_PI};
+    system.operating_region = typename system_t::region_t(oc, os);
+    for(int b=0; b<30; b++)
+    {
+        double c[2] = {rng.uniform(-40, 40), rng.uniform(-40, 40)};
+        double s[2] = {rng.uniform(0.01, 0.1), rng.uniform(1, 20)};
+        if(b % 2)
+            swap(s[0], s[1]);
+        system.obstacle_map.add_box(c, s);
+    }
+    system.clearance_only_xy = clearance_only_xy;
+
+    int errors = 0, num_safe = 0;
+    for(int i=0; i<count; i++)
+    {
+        typename system_t::state si, sf;
+        for(size_t d=0; d<system_t::N; d++)
+        {
+            si.x[d] = (d < 2) ? rng.uniform(-40, 40) : rng.uniform(0, 2*M_PI);
+            sf.x[d] = (d < 2) ? rng.uniform(-40, 40) : rng.uniform(0, 2*M_PI);
+        }
+        typename system_t::trajectory traj;
+        typename system_t::opt_data_t opt_data;
+        if(system.dynamical_system.extend_to(si, sf, traj, opt_data))
+            continue;
+
+        system.collision_check_mode = system_t::strided_collision_check;
+        system.collision_check_stride = 1;
+        bool safe = system.is_safe_trajectory(traj);
+        system.collision_check_mode = system_t::adaptive_collision_check;
+        if(system.is_safe_trajectory(traj) != safe)
+            errors++;
+        num_safe += safe;
+    }
+    cout<<name<<" edges: "<< count <<" collision free: "<< num_safe <<" errors: "<< errors << endl;
+    return errors;
+}
+
+int main()
+{
+    int errors = 0;
+    errors += test_batch(0, 10);
+    errors += test_batch(1, 3);
+    errors += test_batch(50, 1001);
+    errors += test_batch(200, 10000);
+    errors += test_adaptive<system_c<single_integrator_c<2>, box_map_c<2>, region_c<2>, cost_c<1> > >(
+            "single integrator", false, 2000);
+    errors += test_adaptive<system_c<dubins_c, box_map_c<3>, region_c<3>, cost_c<1> > >(
+            "dubins", true, 500);
+    return errors ? 1 : 0;
+}
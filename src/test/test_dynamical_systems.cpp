@@ -0,0 +1,102 @@
+#include <iostream>
+#include <cmath>
+
+#include "../utils.h"
+#include "../random.h"
+#include "../dubins.h"
+#include "../single_integrator.h"
+#include "../double_integrator.h"
+#include "../reeds_shepp.h"
+using namespace std;
+
+/*
+ * steer has to hand out every stride-th state of the trajectory extend_to
+ * returns, for every system that generates them on the fly.
+ */
+random_c rng(0);
+
+template<class system_t>
+int check_steer(system_t& system, const typename system_t::state_t& si,
+        const typename system_t::state_t& sf, size_t stride)
+{
+    typedef typename system_t::state_t state_t;
+    typename system_t::opt_data_t opt_data1, opt_data2;
+    typename system_t::trajectory_t traj;
+    vector<state_t> steered;
+    auto collect = [&](const double* states, size_t count)
+    {
+        for(size_t i=0; i<count; i++)
+            steered.push_back(state_t(states + i*state_t::N));
+        return 0;
+    };
+    // no trajectory between si and sf, steer has to agree
+    if(system.extend_to(si, sf, traj, opt_data1))
+        return system.steer(si, sf, opt_data2, stride, collect) ? 0 : 1;
+
+    int res = system.steer(si, sf, opt_data2, stride, collect);
+    if(res)
+        return 1;
+
+    size_t n = (traj.states.size() + stride - 1)/stride;
+    if(steered.size() != n)
+        return 1;
+    for(size_t i=0; i<n; i++)
+    {
+        if(steered[i].dist(traj.states[i*stride]) > 1e-9)
+            return 1;
+    }
+
+    // a callback that stops at the first block, its value is returned
+    size_t num_calls = 0;
+    res = system.steer(si, sf, opt_data2, stride,
+            [&](const double* states, size_t count)
+            {
+                num_calls++;
+                return 2;
+            });
+    if((res != 2) || (num_calls != 1))
+        return 1;
+    return 0;
+}
+
+template<class system_t>
+int test_steer(system_t& system, const char* name, const double* center, const double* size,
+        int num_pairs)
+{
+    typedef typename system_t::state_t state_t;
+    int errors = 0;
+    size_t strides[] = {1, 3, 100};
+    for(int j=0; j<num_pairs; j++)
+    {
+        double s1[state_t::N], s2[state_t::N];
+        system.sample_state(const_cast<double*>(center), const_cast<double*>(size), s1, rng);
+        system.sample_state(const_cast<double*>(center), const_cast<double*>(size), s2, rng);
+        for(auto stride : strides)
+            errors += check_steer(system, state_t(s1), state_t(s2), stride);
+    }
+    cout<<name<<", pairs: "<< num_pairs <<" errors: "<< errors << endl;
+    return errors;
+}
+
+int main()
+{
+    int errors = 0;
+
+    single_integrator_c<2> single_integrator;
+    double si_c[2] = {0, 0}, si_s[2] = {20, 20};
+    errors += test_steer(single_integrator, "single_integrator_c", si_c, si_s, 50);
+
+    double_integrator_c double_integrator;
+    double di_c[4] = {0, 0, 0, 0}, di_s[4] = {20, 20, 4, 4};
+    errors += test_steer(double_integrator, "double_integrator_c", di_c, di_s, 50);
+
+    dubins_c dubins;
+    double du_c[3] = {0, 0, 0}, du_s[3] = {40, 40, 2*M_PI};
+    errors += test_steer(dubins, "dubins_c", du_c, du_s, 50);
+
+    reeds_shepp_c reeds_shepp;
+    double rs_c[3] = {0, 0, 0}, rs_s[3] = {10, 10, 2*M_PI};
+    errors += test_steer(reeds_shepp, "reeds_shepp_c", rs_c, rs_s, 50);
+
+    return errors ? 1 : 0;
+}
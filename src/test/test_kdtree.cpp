@@ -0,0 +1,298 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "../utils.h"
+#include "../kd_tree.h"
+#include "../random.h"
+using namespace std;
+
+const size_t N = 3;
+typedef kdtree_c<N, int> kdtree_t;
+typedef c_kdtree_c<N, long> c_kdtree_t;
+
+random_c rng(0);
+
+double dist_sq(const double* k1, const double* k2)
+{
+    double t = 0;
+    for(size_t i=0; i<N; i++)
+        t += SQ(k1[i]-k2[i]);
+    return t;
+}
+
+int test_queries(int num_points, int num_queries)
+{
+    vector<double> keys(N*num_points);
+    for(auto& k : keys)
+        k = rng.uniform();
+
+    kdtree_t kdtree;
+    c_kdtree_t c_kdtree;
+    for(int i=0; i<num_points; i++)
+    {
+        kdtree.insert(&keys[N*i], i);
+        c_kdtree.insert(&keys[N*i], i);
+    }
+
+    int errors = 0;
+    double range = 0.1;
+    vector<int> near;
+    vector<long> c_near;
+    for(int j=0; j<num_queries; j++)
+    {
+        double q[N];
+        for(size_t i=0; i<N; i++)
+            q[i] = rng.uniform();
+
+        int best = -1;
+        double best_d2 = 1e10;
+        vector<int> brute_near;
+        for(int i=0; i<num_points; i++)
+        {
+            double d2 = dist_sq(q, &keys[N*i]);
+            if(d2 < best_d2)
+            {
+                best_d2 = d2;
+                best = i;
+            }
+            if(d2 <= range*range)
+                brute_near.push_back(i);
+        }
+
+        int nearest = -1;
+        kdtree.nearest(q, nearest);
+        if(dist_sq(q, &keys[N*nearest]) != best_d2)
+            errors++;
+
+        near.clear();
+        kdtree.near_range(q, range, near);
+        sort(near.begin(), near.end());
+        if(near != brute_near)
+            errors++;
+
+        c_near.clear();
+        c_kdtree.near_range(q, range, c_near);
+        if(c_near.size() != near.size())
+            errors++;
+
+        size_t k = 10;
+        vector<double> brute_d2;
+        for(int i=0; i<num_points; i++)
+            brute_d2.push_back(dist_sq(q, &keys[N*i]));
+        sort(brute_d2.begin(), brute_d2.end());
+        brute_d2.resize(min(k, brute_d2.size()));
+
+        near.clear();
+        kdtree.nearest_n(q, k, near);
+        c_near.clear();
+        c_kdtree.nearest_n(q, k, c_near);
+        if((near.size() != brute_d2.size()) || (c_near.size() != brute_d2.size()))
+            errors++;
+        else
+        {
+            for(size_t i=0; i<near.size(); i++)
+            {
+                if((dist_sq(q, &keys[N*near[i]]) != brute_d2[i]) ||
+                        (dist_sq(q, &keys[N*c_near[i]]) != brute_d2[i]))
+                    errors++;
+            }
+        }
+    }
+    cout<<"points: "<< num_points <<" queries: "<< num_queries <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// erases a random half of the points, some of them twice, and compares
+// the queries with brute force over the rest. sorted inserts points in
+// order of their first coordinate, which needs the partial rebuilds.
+int test_erase(int num_points, int num_queries, bool sorted)
+{
+    vector<double> keys(N*num_points);
+    for(auto& k : keys)
+        k = rng.uniform();
+    if(sorted)
+    {
+        vector<double> t(keys);
+        vector<int> order(num_points);
+        for(int i=0; i<num_points; i++)
+            order[i] = i;
+        sort(order.begin(), order.end(), [&](int i1, int i2){return t[N*i1] < t[N*i2];});
+        for(int i=0; i<num_points; i++)
+            copy(&t[N*order[i]], &t[N*order[i]] + N, &keys[N*i]);
+    }
+
+    kdtree_t kdtree;
+    vector<bool> alive(num_points, true);
+    int errors = 0;
+    for(int i=0; i<num_points; i++)
+    {
+        kdtree.insert(&keys[N*i], i);
+        if(rng.uniform() < 0.5)
+        {
+            int j = rng.uniform_int(i+1);
+            if(kdtree.erase(&keys[N*j], j) != (alive[j] ? 0 : 1))
+                errors++;
+            alive[j] = false;
+        }
+    }
+    size_t num_alive = count(alive.begin(), alive.end(), true);
+    if(kdtree.size() != num_alive)
+        errors++;
+
+    double range = 0.1;
+    vector<int> near;
+    for(int j=0; j<num_queries; j++)
+    {
+        double q[N];
+        for(size_t i=0; i<N; i++)
+            q[i] = rng.uniform();
+
+        double best_d2 = 1e10;
+        vector<int> brute_near;
+        vector<double> brute_d2;
+        for(int i=0; i<num_points; i++)
+        {
+            if(!alive[i])
+                continue;
+            double d2 = dist_sq(q, &keys[N*i]);
+            best_d2 = min(best_d2, d2);
+            if(d2 <= range*range)
+                brute_near.push_back(i);
+            brute_d2.push_back(d2);
+        }
+
+        int nearest = -1;
+        if(kdtree.nearest(q, nearest) != (num_alive ? 0 : 1))
+            errors++;
+        else if(num_alive && (!alive[nearest] || (dist_sq(q, &keys[N*nearest]) != best_d2)))
+            errors++;
+
+        near.clear();
+        kdtree.near_range(q, range, near);
+        sort(near.begin(), near.end());
+        if(near != brute_near)
+            errors++;
+
+        size_t k = 10;
+        sort(brute_d2.begin(), brute_d2.end());
+        brute_d2.resize(min(k, brute_d2.size()));
+        near.clear();
+        kdtree.nearest_n(q, k, near);
+        if(near.size() != brute_d2.size())
+            errors++;
+        else
+        {
+            for(size_t i=0; i<near.size(); i++)
+            {
+                if(!alive[near[i]] || (dist_sq(q, &keys[N*near[i]]) != brute_d2[i]))
+                    errors++;
+            }
+        }
+    }
+    cout<<"erase, points: "<< num_points <<" alive: "<< num_alive
+        <<(sorted ? " sorted" : "") <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// keys on a coarse grid, many of them at the same distance from a query
+// or the same key. nearest_n has to return the k smallest distances in
+// order, each point once, also for k = 0 and k beyond the size.
+int test_nearest_n(int num_points, int num_queries)
+{
+    vector<double> keys(N*num_points);
+    for(auto& k : keys)
+        k = rng.uniform_int(5)/4.0;
+
+    kdtree_t kdtree;
+    for(int i=0; i<num_points; i++)
+        kdtree.insert(&keys[N*i], i);
+
+    int errors = 0;
+    size_t ks[] = {0, 1, 5, 32, (size_t)num_points, (size_t)num_points + 5};
+    vector<int> near;
+    for(int j=0; j<num_queries; j++)
+    {
+        double q[N];
+        for(size_t i=0; i<N; i++)
+            q[i] = (j%2) ? rng.uniform() : rng.uniform_int(5)/4.0;
+
+        vector<double> brute_d2;
+        for(int i=0; i<num_points; i++)
+            brute_d2.push_back(dist_sq(q, &keys[N*i]));
+        sort(brute_d2.begin(), brute_d2.end());
+
+        for(auto k : ks)
+        {
+            near.assign(1, -1);
+            size_t n = kdtree.nearest_n(q, k, near);
+            size_t expected = min(k, brute_d2.size());
+            if((n != expected) || (near.size() != expected + 1) || (near[0] != -1))
+            {
+                errors++;
+                continue;
+            }
+            vector<int> ids(near.begin() + 1, near.end());
+            sort(ids.begin(), ids.end());
+            if(unique(ids.begin(), ids.end()) != ids.end())
+                errors++;
+            for(size_t i=0; i<n; i++)
+            {
+                if(dist_sq(q, &keys[N*near[i+1]]) != brute_d2[i])
+                    errors++;
+            }
+        }
+    }
+    cout<<"nearest_n, points: "<< num_points <<" queries: "<< num_queries <<" errors: "<< errors << endl;
+    return errors;
+}
+
+int time_queries(int num_points, int num_queries)
+{
+    vector<double> keys(N*num_points);
+    for(auto& k : keys)
+        k = rng.uniform();
+    double range = pow(log(num_points)/num_points, 1.0/N);
+
+    tt clock;
+    kdtree_t kdtree;
+    clock.tic();
+    for(int i=0; i<num_points; i++)
+        kdtree.insert(&keys[N*i], i);
+    vector<int> near;
+    for(int j=0; j<num_queries; j++)
+    {
+        near.clear();
+        kdtree.near_range(&keys[N*(j%num_points)], range, near);
+    }
+    cout<<"kdtree_c: "<< clock.toc() <<" [ms]"<<endl;
+
+    c_kdtree_t c_kdtree;
+    clock.tic();
+    for(int i=0; i<num_points; i++)
+        c_kdtree.insert(&keys[N*i], i);
+    vector<long> c_near;
+    for(int j=0; j<num_queries; j++)
+    {
+        c_near.clear();
+        c_kdtree.near_range(&keys[N*(j%num_points)], range, c_near);
+    }
+    cout<<"c_kdtree_c: "<< clock.toc() <<" [ms]"<<endl;
+    return 0;
+}
+
+int main()
+{
+    int errors = 0;
+    errors += test_queries(1, 10);
+    errors += test_queries(100, 1000);
+    errors += test_queries(10000, 1000);
+    errors += test_nearest_n(1, 10);
+    errors += test_nearest_n(500, 200);
+    errors += test_erase(1, 10, false);
+    errors += test_erase(10000, 1000, false);
+    errors += test_erase(10000, 1000, true);
+    time_queries(100000, 20000);
+    return errors ? 1 : 0;
+};
@@ -8,6 +8,11 @@
 #include "../reeds_shepp.h"
 #include "../rrts.h"
 #include "../brrts.h"
+#include "../bitstar.h"
+#include "../fmts.h"
+#include "../birrts.h"
+#include "../rrts_soa.h"
+#include "../lcmgl_plotter.h"
 using namespace std;
 
 int test_single_integrator()
@@ -22,10 +27,11 @@ int test_single_integrator()
 
     lcm_t *lcm          = bot_lcm_get_global(NULL);
     bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
     bot_lcmgl_line_width(lcmgl, 2.0);
     bot_lcmgl_switch_buffer(lcmgl);
 
-    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(lcmgl);
+    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(&plotter);
 
     double zero[3] = {0};
     double size[3] = {100,100,2*M_PI};
@@ -59,7 +65,7 @@ int test_single_integrator()
             cout<<"is safe: "<< rrts.system.is_safe_trajectory(traj)<<endl;
             traj.clear();
             cout<<"switched root: ";
-            rrts.root->state.print();
+            print_state(rrts.root->state);
             cout<<endl;
         }
 #endif
@@ -87,9 +93,10 @@ int test_double_integrator()
 
     lcm_t *lcm          = bot_lcm_get_global(NULL);
     bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
     bot_lcmgl_switch_buffer(lcmgl);
 
-    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(lcmgl);
+    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(&plotter);
 
     double zero[4] = {0};
     double size[4] = {25, 25, 5, 5};
@@ -138,7 +145,6 @@ int test_double_integrator()
 
 int test_brrts()
 {
-    srand(time(NULL));
 
     //typedef system_c<single_integrator_c<3>, map_c<3>, region_c<3>, cost_c<1> > system_t;
     typedef system_c<double_integrator_c, map_c<4>, region_c<4>, cost_c<1> > system_t;
@@ -150,9 +156,11 @@ int test_brrts()
 
     lcm_t *lcm          = bot_lcm_get_global(NULL);
     bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
     bot_lcmgl_switch_buffer(lcmgl);
 
-    brrts_c<bvertex_c<system_t>, bedge_c<system_t> > brrts(lcmgl);
+    brrts_c<bvertex_c<system_t>, bedge_c<system_t> > brrts(&plotter);
+    brrts.system.rng.seed(time(NULL));
 
     double zero[4] = {0};
     double size[4] = {25, 25, 10, 10};
@@ -197,10 +205,11 @@ int test_dubins()
 
     lcm_t *lcm          = bot_lcm_get_global(NULL);
     bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
     bot_lcmgl_line_width(lcmgl, 2.0);
     bot_lcmgl_switch_buffer(lcmgl);
 
-    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(lcmgl);
+    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(&plotter);
 
     double zero[3] = {0};
     double size[3] = {100,100,2*M_PI};
@@ -252,10 +261,11 @@ int test_dubins_velocity()
 
     lcm_t *lcm          = bot_lcm_get_global(NULL);
     bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
     bot_lcmgl_line_width(lcmgl, 2.0);
     bot_lcmgl_switch_buffer(lcmgl);
 
-    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(lcmgl);
+    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(&plotter);
 
     double zero[4] = {0};
     double size[4] = {25,25,2*M_PI, 5};
@@ -309,10 +319,11 @@ int test_reeds_shepp()
 
     lcm_t *lcm          = bot_lcm_get_global(NULL);
     bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
     bot_lcmgl_line_width(lcmgl, 2.0);
     bot_lcmgl_switch_buffer(lcmgl);
 
-    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(lcmgl);
+    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts(&plotter);
 
     double zero[3] = {0};
     double size[3] = {25,25,2*M_PI};
@@ -356,6 +367,182 @@ int test_reeds_shepp()
     return 0;
 }
 
+int test_bitstar()
+{
+    typedef system_c<dubins_c, map_c<3>, region_c<3>, cost_c<1> > system_t;
+
+    typedef system_t::state state;
+    typedef typename system_t::region_t region;
+
+    lcm_t *lcm          = bot_lcm_get_global(NULL);
+    bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
+    bot_lcmgl_line_width(lcmgl, 2.0);
+    bot_lcmgl_switch_buffer(lcmgl);
+
+    bitstar_c<vertex_c<system_t>, edge_c<system_t> > bitstar(&plotter, 200);
+
+    double zero[3] = {0};
+    double size[3] = {100,100,2*M_PI};
+    bitstar.system.operating_region = region(zero, size);
+
+    double gc[3] = {10, 10, M_PI/2. + 0.1};
+    double gs[3] = {1, 1, 0.01*M_PI};
+    bitstar.system.goal_region = region(gc,gs);
+    bitstar.goal_sample_freq = 0.3;
+
+    state origin(zero);
+    bitstar.initialize(origin);
+
+    tt clock;
+    clock.tic();
+    int max_batches = 100;
+    for(int i=0; i<max_batches; i++)
+    {
+        bitstar.iterate_batch();
+        cout<<i<<" "<<bitstar.num_vertices<<" "<<bitstar.get_best_cost().val[0]<<endl;
+
+        bitstar.plot_tree();
+        bitstar.plot_best_trajectory();
+        bot_lcmgl_switch_buffer(lcmgl);
+    }
+    cout<<"time: "<< clock.toc() <<" [ms]"<<endl;
+    cout<<bitstar.get_best_cost().val[0]<<endl;
+
+    return 0;
+}
+
+int test_fmts()
+{
+    typedef system_c<dubins_c, map_c<3>, region_c<3>, cost_c<1> > system_t;
+
+    typedef system_t::state state;
+    typedef typename system_t::region_t region;
+
+    lcm_t *lcm          = bot_lcm_get_global(NULL);
+    bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
+    bot_lcmgl_line_width(lcmgl, 2.0);
+    bot_lcmgl_switch_buffer(lcmgl);
+
+    fmts_c<vertex_c<system_t>, edge_c<system_t> > fmts(&plotter, 5000);
+
+    double zero[3] = {0};
+    double size[3] = {100,100,2*M_PI};
+    fmts.system.operating_region = region(zero, size);
+
+    double gc[3] = {10, 10, M_PI/2. + 0.1};
+    double gs[3] = {1, 1, 0.01*M_PI};
+    fmts.system.goal_region = region(gc,gs);
+    fmts.goal_sample_freq = 0.05;
+
+    tt clock;
+    clock.tic();
+    state origin(zero);
+    fmts.initialize(origin);
+    if(fmts.solve())
+        cout<<"no solution"<<endl;
+    cout<<"time: "<< clock.toc() <<" [ms]"<<endl;
+    cout<<fmts.num_vertices<<" "<<fmts.get_best_cost().val[0]<<endl;
+
+    fmts.plot_tree();
+    fmts.plot_best_trajectory();
+    bot_lcmgl_switch_buffer(lcmgl);
+    return 0;
+}
+
+int test_birrts()
+{
+    typedef system_c<reeds_shepp_c, map_c<3>, region_c<3>, cost_c<1> > system_t;
+
+    typedef system_t::state state;
+    typedef typename system_t::region_t region;
+
+    lcm_t *lcm          = bot_lcm_get_global(NULL);
+    bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
+    bot_lcmgl_line_width(lcmgl, 2.0);
+    bot_lcmgl_switch_buffer(lcmgl);
+
+    birrts_c<vertex_c<system_t>, edge_c<system_t>, bvertex_c<system_t>, bedge_c<system_t> > birrts(&plotter);
+
+    double zero[3] = {0};
+    double size[3] = {100,100,2*M_PI};
+    birrts.forward.system.operating_region = region(zero, size);
+
+    double gc[3] = {10, 10, M_PI/2. + 0.1};
+    double gs[3] = {0.1, 0.1, 0.01*M_PI};
+    birrts.forward.system.goal_region = region(gc,gs);
+
+    state origin(zero);
+    birrts.initialize(origin);
+
+    tt clock;
+    clock.tic();
+    int max_iterations = 1e3, diter=max_iterations/10;
+    for(int i=0; i<max_iterations; i++)
+    {
+        birrts.iteration();
+        if(i%diter == 0)
+        {
+            cout<<i<<" "<<birrts.get_num_bridges()<<" "<<birrts.get_best_cost().val[0]<<endl;
+            birrts.plot_tree();
+            birrts.plot_best_trajectory();
+            bot_lcmgl_switch_buffer(lcmgl);
+        }
+    }
+    cout<<"time: "<< clock.toc() <<" [ms]"<<endl;
+    cout<<birrts.get_best_cost().val[0]<<endl;
+    return 0;
+}
+
+int test_rrts_soa()
+{
+    typedef system_c<single_integrator_c<2>, map_c<2>, region_c<2>, fixed_cost_c<1> > system_t;
+
+    typedef system_t::state state;
+    typedef typename system_t::region_t region;
+
+    lcm_t *lcm          = bot_lcm_get_global(NULL);
+    bot_lcmgl_t *lcmgl  = bot_lcmgl_init(lcm, "plotter");
+    lcmgl_plotter_c plotter(lcmgl);
+    bot_lcmgl_line_width(lcmgl, 2.0);
+    bot_lcmgl_switch_buffer(lcmgl);
+
+    rrts_soa_c<system_t> rrts(&plotter);
+
+    double zero[2] = {0};
+    double size[2] = {100,100};
+    rrts.system.operating_region = region(zero, size);
+
+    double gc[2] = {40, 40};
+    double gs[2] = {5, 5};
+    rrts.system.goal_region = region(gc,gs);
+
+    int max_iterations = 1e5, diter=max_iterations/10;
+    rrts.reserve(max_iterations);
+
+    state origin(zero);
+    rrts.initialize(origin);
+
+    tt clock;
+    clock.tic();
+    for(int i=0; i<max_iterations; i++)
+    {
+        rrts.iteration();
+        if(i%diter == 0)
+        {
+            cout<<i<<" "<<rrts.num_vertices<<" "<<rrts.get_best_cost().val[0]<<endl;
+            rrts.plot_tree();
+            rrts.plot_best_trajectory();
+            bot_lcmgl_switch_buffer(lcmgl);
+        }
+    }
+    cout<<"time: "<< clock.toc() <<" [ms]"<<endl;
+    cout<<rrts.get_best_cost().val[0]<<endl;
+    return 0;
+}
+
 int main()
 {
 
@@ -363,6 +550,10 @@ int main()
     //test_double_integrator();
     test_dubins();
     //test_brrts();
+    //test_bitstar();
+    //test_fmts();
+    //test_birrts();
+    //test_rrts_soa();
     //test_dubins_velocity();
     //test_reeds_shepp();
     return 0;
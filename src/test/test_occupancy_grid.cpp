@@ -0,0 +1,137 @@
+#include <iostream>
+#include <fstream>
+#include <cmath>
+
+#include "../utils.h"
+#include "../random.h"
+#include "../occupancy_grid.h"
+using namespace std;
+
+// brute-force distance between cell centers
+template<class map_t>
+double brute_distance(map_t& map, const double* s)
+{
+    long id = map.get_cell(s);
+    double best = 1e10;
+    for(size_t j=0; j<map.num_cells; j++)
+    {
+        if(!map.is_occupied_cell(j))
+            continue;
+        double t = 0;
+        for(size_t d=0; d<3; d++)
+        {
+            double dc = (long)(id/map.stride[d] % map.cells[d]) - (long)(j/map.stride[d] % map.cells[d]);
+            t += SQ(dc*map.resolution);
+        }
+        best = min(best, sqrt(t));
+    }
+    return best;
+}
+
+int test_distance_field()
+{
+    random_c rng(2);
+    distance_field_c<3, 3> map;
+    double origin[3] = {-5, -5, 0};
+    int cells[3] = {40, 30, 8};
+    map.resize(origin, cells, 0.25);
+    for(int i=0; i<5; i++)
+    {
+        double c[3] = {rng.uniform(-5, 5), rng.uniform(-2.5, 2.5), rng.uniform(0.0, 2.0)};
+        double s[3] = {rng.uniform(0.1, 1), rng.uniform(0.1, 1), rng.uniform(0.1, 1)};
+        map.add_box(c, s);
+    }
+    map.compute_distance_field();
+
+    int errors = 0;
+    for(int i=0; i<500; i++)
+    {
+        double s[3] = {rng.uniform(-5, 5), rng.uniform(-2.5, 2.5), rng.uniform(0.0, 2.0)};
+        if(fabs(map.get_distance(s) - brute_distance(map, s)) > 1e-4)
+            errors++;
+        if(map.is_in_collision(s) != map.occupancy_grid_t::is_in_collision(s))
+            errors++;
+    }
+    cout<<"distance field errors: "<< errors << endl;
+    return errors;
+}
+
+// no state within get_clearance() of another one may be in collision,
+// including those that leave the grid
+int test_clearance()
+{
+    random_c rng(4);
+    distance_field_c<3, 2> map;
+    double origin[2] = {-5, -5};
+    int cells[2] = {40, 40};
+    map.resize(origin, cells, 0.25);
+    for(int i=0; i<8; i++)
+    {
+        double c[2] = {rng.uniform(-5, 5), rng.uniform(-5, 5)};
+        double s[2] = {rng.uniform(0.1, 1.5), rng.uniform(0.1, 1.5)};
+        map.add_box(c, s);
+    }
+    map.compute_distance_field();
+
+    int errors = 0, num_clear = 0;
+    for(int k=0; k<2; k++)
+    {
+        map.robot_radius = k ? 0.3 : 0;
+        for(int i=0; i<2000; i++)
+        {
+            double s[3] = {rng.uniform(-5, 5), rng.uniform(-5, 5), 0};
+            double c = map.get_clearance(s);
+            if(c <= 0)
+                continue;
+            num_clear++;
+            if(map.is_in_collision(s))
+                errors++;
+            for(int j=0; j<20; j++)
+            {
+                double a = rng.uniform(0, 2*M_PI), r = c*(j < 10 ? 0.999 : rng.uniform(0.0, 1.0));
+                double p[3] = {s[0] + r*cos(a), s[1] + r*sin(a), 0};
+                if(map.is_in_collision(p))
+                    errors++;
+            }
+        }
+    }
+    cout<<"clearance, states with clearance: "<< num_clear <<" errors: "<< errors << endl;
+    return errors;
+}
+
+int test_pgm()
+{
+    const char* filename = "test_occupancy_grid.pgm";
+    {
+        ofstream f(filename, ios::binary);
+        f << "P5\n# test\n4 3\n255\n";
+        unsigned char px[12] = {0,255,255,255, 255,255,255,255, 255,255,255,10};
+        f.write((const char*)px, 12);
+    }
+    occupancy_grid_c<3, 2> map;
+    double origin[2] = {0, 0};
+    int errors = 0;
+    if(map.load_pgm(filename, origin, 1))
+        errors++;
+    double top_left[3] = {0.5, 2.5, 0}, bottom_right[3] = {3.5, 0.5, 0}, free_cell[3] = {1.5, 1.5, 0};
+    if(!map.is_in_collision(top_left) || !map.is_in_collision(bottom_right) || map.is_in_collision(free_cell))
+        errors++;
+
+    const char* binname = "test_occupancy_grid.bin";
+    occupancy_grid_c<3, 2> map2;
+    if(map.save_binary(binname) || map2.load_binary(binname) || (map2.bits != map.bits))
+        errors++;
+    remove(filename);
+    remove(binname);
+    cout<<"pgm errors: "<< errors << endl;
+    return errors;
+}
+
+int main()
+{
+    int errors = 0;
+    errors += test_distance_field();
+    errors += test_clearance();
+    errors += test_pgm();
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,703 @@
+#include <iostream>
+#include <cmath>
+#include <map>
+
+#include "../utils.h"
+#include "../single_integrator.h"
+#include "../dubins.h"
+#include "../map.h"
+#include "../box_map.h"
+#include "../rrts.h"
+#include "../brrts.h"
+#include "../parallel_rrts.h"
+#include "../birrts.h"
+#include "../rrts_soa.h"
+#include "../bitstar.h"
+#include "../fmts.h"
+using namespace std;
+
+/*
+ * Headless checks of the planners, the drawing examples are in test_main.
+ * Every run is seeded, so the numbers are the same on every machine.
+ */
+typedef system_c<single_integrator_c<2>, map_c<2>, region_c<2>, cost_c<1> > si_system_t;
+typedef rrts_c<vertex_c<si_system_t>, edge_c<si_system_t> > si_rrts_t;
+typedef system_c<single_integrator_c<2>, box_map_c<2>, region_c<2>, cost_c<1> > si_box_system_t;
+
+template<class system_t>
+void set_si_problem(system_t& system, double goal_size)
+{
+    double oc[2] = {0, 0}, os[2] = {100, 100};
+    double gc[2] = {40, 40}, gs[2] = {goal_size, goal_size};
+    system.operating_region = region_c<2>(oc, os);
+    system.goal_region = region_c<2>(gc, gs);
+    system.rng.seed(1);
+}
+
+// the best path ends at the near corner of a large goal region, shorter
+// than the distance to its center. Informed sampling has to keep that path
+// inside its hyperspheroid and end up within 0.1% of uniform sampling.
+int test_informed_goal_region()
+{
+    int errors = 0;
+    double costs[2];
+    for(int informed=0; informed<2; informed++)
+    {
+        si_rrts_t rrts;
+        set_si_problem(rrts.system, 5);
+        rrts.system.use_informed_sampling = informed;
+        double s0[2] = {0, 0};
+        rrts.initialize(si_system_t::state(s0));
+        for(int i=0; i<5000; i++)
+            rrts.iteration();
+        costs[informed] = rrts.get_best_cost().val[0];
+        if(informed && !(rrts.system.get_informed_volume_fraction() > 0))
+            errors++;
+    }
+    if(costs[1] > costs[0]*1.001)
+        errors++;
+
+    // a cost just above the one of the path to the near corner
+    si_system_t system;
+    set_si_problem(system, 5);
+    double s0[2] = {0, 0}, corner[2] = {37.5, 37.5};
+    system.use_informed_sampling = true;
+    system.set_informed_cost(si_system_t::state(s0), 37.5*sqrt(2) + 0.1);
+    for(int i=1; i<10; i++)
+    {
+        double s[2] = {corner[0]*i/10, corner[1]*i/10};
+        if(!system.can_improve_informed_cost(si_system_t::state(s)))
+            errors++;
+    }
+    if(!(system.get_informed_volume_fraction() > 0))
+        errors++;
+    si_system_t::state s;
+    if(system.sample_informed(s, system.rng) || !system.can_improve_informed_cost(s))
+        errors++;
+
+    cout<<"informed, uniform: "<< costs[0] <<" informed: "<< costs[1] <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// parallel_rrts_c shares rrts_c's tree surgery code with a kd-tree that
+// cannot erase, this also makes sure it still builds
+int test_parallel_rrts()
+{
+    parallel_rrts_c<vertex_c<si_system_t>, edge_c<si_system_t> > rrts(NULL, 4);
+    set_si_problem(rrts.system, 5);
+    double s0[2] = {0, 0};
+    rrts.initialize(si_system_t::state(s0));
+    rrts.iterate(3000);
+
+    int errors = 0;
+    si_system_t::trajectory traj;
+    if(rrts.get_best_trajectory(traj) || (rrts.get_best_cost().val[0] > 60))
+        errors++;
+    cout<<"parallel_rrts_c, cost: "<< rrts.get_best_cost().val[0] <<" errors: "<< errors << endl;
+    return errors;
+}
+
+template<class system_t>
+int count_colliding_states(system_t& system, const typename system_t::trajectory& traj)
+{
+    int n = 0;
+    for(auto& s : traj.states)
+        n += system.is_in_collision(s);
+    return n;
+}
+
+// a box on the straight path, the shortest path goes around its corner at
+// (25, 15) to the corner (37.5, 37.5) of the goal region. Every state is
+// checked, so that no path cuts the corner between two checked states.
+template<class system_t>
+void set_box_problem(system_t& system)
+{
+    set_si_problem(system, 5);
+    double bc[2] = {20, 20}, bs[2] = {10, 10};
+    system.obstacle_map.add_box(bc, bs);
+    system.collision_check_stride = 1;
+}
+const double box_problem_cost = sqrt(25*25 + 15*15) + sqrt(12.5*12.5 + 22.5*22.5);
+
+// best cost of rrts_c after n iterations on the box problem
+double get_box_rrts_cost(int n)
+{
+    rrts_c<vertex_c<si_box_system_t>, edge_c<si_box_system_t> > rrts;
+    set_box_problem(rrts.system);
+    double s0[2] = {0, 0};
+    rrts.initialize(si_box_system_t::state(s0));
+    for(int i=0; i<n; i++)
+        rrts.iteration();
+    return rrts.get_best_cost().val[0];
+}
+
+// the batch planners draw from other random streams than rrts_c, with the
+// same number of samples they have to end up within 1% of it and their
+// paths have to be collision free and no shorter than the shortest one
+template<class planner_t>
+int check_box_solution(planner_t& planner, double rrts_cost)
+{
+    int errors = 0;
+    typename planner_t::trajectory_t traj;
+    if(planner.get_best_trajectory(traj) || count_colliding_states(planner.system, traj))
+        errors++;
+    double cost = planner.get_best_cost().val[0];
+    if((cost > rrts_cost*1.01) || (cost < box_problem_cost - 1e-6))
+        errors++;
+    return errors;
+}
+
+// counts the states it is asked about
+class counting_box_map_c : public box_map_c<2>
+{
+    public:
+        size_t num_queries;
+
+        counting_box_map_c() : num_queries(0) {}
+
+        bool is_in_collision(const double s[2])
+        {
+            num_queries++;
+            return box_map_c<2>::is_in_collision(s);
+        }
+        int is_in_collision_batch(const double* states, size_t count, uint8_t* out)
+        {
+            num_queries += count;
+            return box_map_c<2>::is_in_collision_batch(states, count, out);
+        }
+};
+
+// lazy RRT* has to go around the box like RRT* does, with far fewer
+// states checked
+int test_lazy()
+{
+    typedef system_c<single_integrator_c<2>, counting_box_map_c, region_c<2>, cost_c<1> > system_t;
+    double costs[2];
+    size_t queries[2];
+    int errors = 0;
+    for(int lazy=0; lazy<2; lazy++)
+    {
+        rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts;
+        set_box_problem(rrts.system);
+        rrts.lazy_collision_checking = lazy;
+        double s0[2] = {0, 0};
+        rrts.initialize(system_t::state(s0));
+        for(int i=0; i<3000; i++)
+            rrts.iteration();
+
+        system_t::trajectory traj;
+        if(rrts.get_best_trajectory(traj))
+            errors++;
+        queries[lazy] = rrts.system.obstacle_map.num_queries;
+        if(count_colliding_states(rrts.system, traj))
+            errors++;
+        costs[lazy] = rrts.get_best_cost().val[0];
+    }
+    if((costs[1] > costs[0]*1.005) || (costs[1] < box_problem_cost - 1e-6))
+        errors++;
+    if(queries[1]*2 > queries[0])
+        errors++;
+    cout<<"lazy, cost: "<< costs[0] <<" -> "<< costs[1] <<" map queries: "<< queries[0] <<" -> "<< queries[1]
+        <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// k-nearest RRT* has to go around the box too and end up close to the
+// cost of the radius version
+int test_k_nearest()
+{
+    double costs[2];
+    int errors = 0;
+    for(int k_nearest=0; k_nearest<2; k_nearest++)
+    {
+        rrts_c<vertex_c<si_box_system_t>, edge_c<si_box_system_t> > rrts;
+        set_box_problem(rrts.system);
+        rrts.use_k_nearest = k_nearest;
+        double s0[2] = {0, 0};
+        rrts.initialize(si_box_system_t::state(s0));
+        for(int i=0; i<3000; i++)
+            rrts.iteration();
+
+        si_box_system_t::trajectory traj;
+        if(rrts.get_best_trajectory(traj) || count_colliding_states(rrts.system, traj))
+            errors++;
+        costs[k_nearest] = rrts.get_best_cost().val[0];
+    }
+    if((costs[1] > costs[0]*1.02) || (costs[1] < box_problem_cost - 1e-6))
+        errors++;
+    cout<<"k-nearest, cost: "<< costs[0] <<" -> "<< costs[1] <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// vertices whose cost is not the one of their parent plus their edge
+template<class planner_t>
+int count_stale_costs(planner_t& planner)
+{
+    int n = 0;
+    for(auto& pv : planner.list_vertices)
+    {
+        if(!pv->parent)
+            continue;
+        typename planner_t::cost_t c = pv->parent->cost_from_root + pv->cost_from_parent;
+        n += (fabs(c.val[0] - pv->cost_from_root.val[0]) > 1e-9) || !pv->parent->children.count(pv);
+    }
+    return n;
+}
+
+// rewires have to leave every cost equal to the parent's plus the edge's,
+// update_branch_cost(v, true) and update_all_costs also have to repair
+// costs below vertices whose own cost did not change
+int test_branch_costs()
+{
+    typedef rrts_c<vertex_c<si_box_system_t>, edge_c<si_box_system_t> > rrts_t;
+    typedef rrts_t::vertex vertex_t;
+    rrts_t rrts;
+    set_box_problem(rrts.system);
+    double s0[2] = {0, 0};
+    rrts.initialize(si_box_system_t::state(s0));
+    int errors = 0;
+    for(int j=0; j<6; j++)
+    {
+        for(int i=0; i<500; i++)
+            rrts.iteration();
+        errors += count_stale_costs(rrts);
+    }
+    double best_cost = rrts.get_best_cost().val[0];
+
+    // x's cost is off but its parent w's is not, the walk from above w
+    // stops at w unless forced
+    vertex_t* x = &(rrts.get_best_vertex());
+    while(x->parent->parent->parent != rrts.root)
+        x = x->parent;
+    vertex_t& w = *(x->parent);
+    x->cost_from_root.val[0] += 1;
+    rrts.update_branch_cost(*(w.parent));
+    if(count_stale_costs(rrts) == 0)
+        errors++;
+    rrts.update_branch_cost(*(w.parent), true);
+    errors += count_stale_costs(rrts);
+
+    // every tenth vertex off
+    int i = 0;
+    for(auto& pv : rrts.list_vertices)
+    {
+        if(pv->parent && !(i++ % 10))
+            pv->cost_from_root.val[0] += 1;
+    }
+    rrts.update_all_costs();
+    errors += count_stale_costs(rrts);
+    if(fabs(rrts.get_best_cost().val[0] - best_cost) > 1e-9)
+        errors++;
+    cout<<"branch costs, vertices: "<< rrts.num_vertices <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// plan_for has to return shortly after its deadline with the stats filled
+// in, and stop early on max_iterations and when the cost stalls
+template<class planner_t>
+int test_plan_for(const char* name)
+{
+    typedef typename planner_t::system_t system_t;
+    typedef chrono::duration<double> seconds_t;
+    int errors = 0;
+    double s0[2] = {0, 0};
+    typename system_t::trajectory traj;
+    plan_stats_t stats;
+
+    planner_t deadline_planner;
+    set_box_problem(deadline_planner.system);
+    deadline_planner.initialize(typename system_t::state(s0));
+    plan_clock_t::time_point t0 = plan_clock_t::now();
+    if(deadline_planner.plan_for(chrono::milliseconds(100), traj, &stats))
+        errors++;
+    double elapsed = seconds_t(plan_clock_t::now() - t0).count();
+    if((elapsed < 0.1) || (elapsed > 0.15) || (stats.stop_reason != plan_stats_t::stopped_deadline))
+        errors++;
+    if(!stats.iterations || !stats.added_vertices || (stats.added_vertices > stats.iterations)
+            || (stats.interrupted_iterations > 1))
+        errors++;
+    if((stats.time < 0.1) || (stats.time > elapsed) || (stats.first_solution_time < 0)
+            || (stats.first_solution_time > stats.time))
+        errors++;
+    if((stats.final_cost > stats.initial_cost) || (stats.final_cost < box_problem_cost - 1e-6)
+            || (fabs(stats.final_cost - deadline_planner.get_best_cost().val[0]) > 1e-9))
+        errors++;
+    double deadline_elapsed = elapsed;
+
+    planner_t iterations_planner;
+    set_box_problem(iterations_planner.system);
+    iterations_planner.initialize(typename system_t::state(s0));
+    iterations_planner.budget.max_iterations = 300;
+    iterations_planner.plan_for(chrono::seconds(10), traj, &stats);
+    if((stats.stop_reason != plan_stats_t::stopped_iterations) || (stats.iterations != 300)
+            || (stats.time > 5))
+        errors++;
+
+    // any improvement below half the cost counts as a stall
+    planner_t stall_planner;
+    set_box_problem(stall_planner.system);
+    stall_planner.initialize(typename system_t::state(s0));
+    stall_planner.budget.stall_time = 0.05;
+    stall_planner.budget.stall_improvement = 0.5;
+    stall_planner.plan_for(chrono::seconds(10), traj, &stats);
+    if((stats.stop_reason != plan_stats_t::stopped_stalled) || (stats.first_solution_time < 0)
+            || (stats.time < stats.first_solution_time + 0.05) || (stats.time > 5))
+        errors++;
+    double stall_elapsed = stats.time;
+
+    cout<< name <<" plan_for, deadline: "<< deadline_elapsed <<" stalled: "<< stall_elapsed
+        <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// the states of a tree in the order they were added
+template<class planner_t>
+vector<double> get_tree_states(planner_t& planner)
+{
+    vector<double> t;
+    for(auto& pv : planner.list_vertices)
+        t.insert(t.end(), pv->state.x, pv->state.x + planner_t::system_t::N);
+    return t;
+}
+
+// equal seeds have to grow equal trees, also when birrts_c forks the
+// stream of its backward tree
+int test_seeds()
+{
+    typedef birrts_c<vertex_c<si_box_system_t>, edge_c<si_box_system_t>,
+            bvertex_c<si_box_system_t>, bedge_c<si_box_system_t> > birrts_t;
+    int errors = 0;
+    double s0[2] = {0, 0};
+    vector<double> trees[3];
+    vector<double> forward_trees[3], backward_trees[3];
+    for(int j=0; j<3; j++)
+    {
+        rrts_c<vertex_c<si_box_system_t>, edge_c<si_box_system_t> > rrts;
+        set_box_problem(rrts.system);
+        rrts.system.rng.seed(j < 2 ? 7 : 8);
+        rrts.initialize(si_box_system_t::state(s0));
+        for(int i=0; i<1000; i++)
+            rrts.iteration();
+        trees[j] = get_tree_states(rrts);
+
+        birrts_t birrts;
+        set_box_problem(birrts.forward.system);
+        birrts.forward.system.rng.seed(j < 2 ? 7 : 8);
+        birrts.initialize(si_box_system_t::state(s0));
+        for(int i=0; i<500; i++)
+            birrts.iteration();
+        forward_trees[j] = get_tree_states(birrts.forward);
+        backward_trees[j] = get_tree_states(birrts.backward);
+    }
+    if((trees[0] != trees[1]) || (trees[0] == trees[2]))
+        errors++;
+    if((forward_trees[0] != forward_trees[1]) || (backward_trees[0] != backward_trees[1]))
+        errors++;
+    if((forward_trees[0] == forward_trees[2]) || (backward_trees[0] == backward_trees[2]))
+        errors++;
+    cout<<"seeds, vertices: "<< trees[0].size()/2 <<" "<< trees[2].size()/2 <<" errors: "<< errors << endl;
+    return errors;
+}
+
+int test_bitstar()
+{
+    double rrts_cost = get_box_rrts_cost(1000);
+    bitstar_c<vertex_c<si_box_system_t>, edge_c<si_box_system_t> > bitstar(100);
+    set_box_problem(bitstar.system);
+    double s0[2] = {0, 0};
+    bitstar.initialize(si_box_system_t::state(s0));
+    for(int i=0; i<10; i++)
+        bitstar.iterate_batch();
+
+    int errors = check_box_solution(bitstar, rrts_cost);
+    cout<<"bitstar_c, cost: "<< bitstar.get_best_cost().val[0] <<" rrts_c: "<< rrts_cost
+        <<" errors: "<< errors << endl;
+    return errors;
+}
+
+int test_fmts()
+{
+    double rrts_cost = get_box_rrts_cost(1000);
+    fmts_c<vertex_c<si_box_system_t>, edge_c<si_box_system_t> > fmts(1000);
+    set_box_problem(fmts.system);
+    double s0[2] = {0, 0};
+    fmts.initialize(si_box_system_t::state(s0));
+
+    int errors = 0;
+    if(fmts.solve())
+        errors++;
+    errors += check_box_solution(fmts, rrts_cost);
+    cout<<"fmts_c, cost: "<< fmts.get_best_cost().val[0] <<" rrts_c: "<< rrts_cost
+        <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// a box dropped on the straight path after the trees connected, the
+// bridges through it and those to freed vertices have to go
+int test_birrts_check_tree()
+{
+    typedef si_box_system_t system_t;
+    birrts_c<vertex_c<system_t>, edge_c<system_t>, bvertex_c<system_t>, bedge_c<system_t> > birrts;
+    set_si_problem(birrts.forward.system, 5);
+    double s0[2] = {0, 0};
+    birrts.initialize(system_t::state(s0));
+    for(int i=0; i<1000; i++)
+        birrts.iteration();
+
+    int errors = 0;
+    size_t num_bridges = birrts.get_num_bridges();
+    if(!num_bridges)
+        errors++;
+
+    double bc[2] = {20, 20}, bs[2] = {10, 10};
+    birrts.forward.system.obstacle_map.add_box(bc, bs);
+    birrts.backward.system.obstacle_map.add_box(bc, bs);
+    if(birrts.check_tree())
+        errors++;
+    if(birrts.get_num_bridges() >= num_bridges)
+        errors++;
+
+    for(int i=0; i<1000; i++)
+        birrts.iteration();
+    system_t::trajectory traj;
+    if(birrts.get_best_trajectory(traj) || count_colliding_states(birrts.forward.system, traj))
+        errors++;
+    cout<<"birrts_c, bridges: "<< num_bridges <<" -> "<< birrts.get_num_bridges()
+        <<" cost: "<< birrts.get_best_cost().val[0] <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// same system, same seed: rrts_soa_c has to grow the tree rrts_c grows,
+// also after check_tree prunes and compacts it
+int test_rrts_soa()
+{
+    typedef system_c<single_integrator_c<2>, box_map_c<2>, region_c<2>, fixed_cost_c<1> > system_t;
+    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts;
+    rrts_soa_c<system_t> soa;
+    set_si_problem(rrts.system, 5);
+    set_si_problem(soa.system, 5);
+    double s0[2] = {0, 0};
+    rrts.initialize(system_t::state(s0));
+    soa.initialize(system_t::state(s0));
+
+    int errors = 0;
+    double bc[2] = {20, 20}, bs[2] = {10, 10};
+    for(int step=0; step<3; step++)
+    {
+        if(step == 1)
+        {
+            rrts.system.obstacle_map.add_box(bc, bs);
+            soa.system.obstacle_map.add_box(bc, bs);
+            rrts.check_tree();
+            soa.check_tree();
+        }
+        else
+        {
+            for(int i=0; i<1500; i++)
+            {
+                rrts.iteration();
+                soa.iteration();
+            }
+        }
+        if(rrts.num_vertices != soa.num_vertices)
+            errors++;
+        if(fabs(rrts.get_best_cost().val[0] - soa.get_best_cost().val[0]) > 1e-9)
+            errors++;
+        cout<<"rrts_soa_c, vertices: "<< rrts.num_vertices <<" "<< soa.num_vertices
+            <<" cost: "<< rrts.get_best_cost().val[0] <<" "<< soa.get_best_cost().val[0] << endl;
+    }
+    cout<<"rrts_soa_c, errors: "<< errors << endl;
+    return errors;
+}
+
+template<class trajectory_t>
+bool is_same_trajectory(const trajectory_t& t1, const trajectory_t& t2)
+{
+    if(t1.states.size() != t2.states.size())
+        return false;
+    for(size_t i=0; i<t1.states.size(); i++)
+    {
+        if(t1.states[i].dist(t2.states[i]) > 1e-12)
+            return false;
+    }
+    return true;
+}
+
+// cached edge trajectories have to be what extend_to returns, and go with
+// the edge when insert_edge or a rewire replaces it
+int test_edge_trajectories()
+{
+    typedef si_rrts_t::vertex vertex_t;
+    int errors = 0;
+    si_rrts_t rrts;
+    set_si_problem(rrts.system, 5);
+    double s0[2] = {0, 0};
+    rrts.initialize(si_system_t::state(s0));
+    for(int i=0; i<1000; i++)
+        rrts.iteration();
+
+    si_system_t::trajectory traj, buffer;
+    if(rrts.get_best_trajectory(traj))
+        errors++;
+    map<vertex_t*, vertex_t*> cached_parents;
+    for(auto& pv : rrts.list_vertices)
+    {
+        if(!pv->parent)
+            continue;
+        const si_system_t::trajectory* cached;
+        rrts.get_edge_trajectory(*pv, cached, buffer, true);
+        si_system_t::trajectory fresh;
+        rrts.system.extend_to(pv->parent->state, pv->state, false, fresh, pv->edge_from_parent->opt_data);
+        if(!pv->edge_from_parent->traj || (cached != pv->edge_from_parent->traj)
+                || !is_same_trajectory(*cached, fresh))
+            errors++;
+        cached_parents[pv] = pv->parent;
+    }
+
+    // a new edge from the grandparent of the goal vertex
+    vertex_t& v = rrts.get_best_vertex();
+    vertex_t& g = *(v.parent->parent);
+    si_system_t::opt_data_t opt_data;
+    si_system_t::cost_t edge_cost;
+    double dt;
+    rrts.system.evaluate_extend_cost(g.state, v.state, opt_data, edge_cost, dt);
+    si_rrts_t::edge* e = rrts.edge_pool.construct(&(g.state), &(v.state), edge_cost, dt, opt_data);
+    rrts.insert_edge(g, *e, v);
+    rrts.update_branch_cost(v);
+    const si_system_t::trajectory* cached;
+    if(v.edge_from_parent->traj || rrts.get_edge_trajectory(v, cached, buffer, true)
+            || (cached->states.front().dist(g.state) > 1e-12))
+        errors++;
+    cached_parents[&v] = &g;
+
+    // rewires have to drop the trajectories of the edges they replace
+    for(int i=0; i<3000; i++)
+        rrts.iteration();
+    int num_rewired = 0;
+    for(auto& p : cached_parents)
+    {
+        vertex_t& u = *(p.first);
+        if(u.parent != p.second)
+        {
+            num_rewired++;
+            if(u.edge_from_parent->traj)
+                errors++;
+        }
+        else if(!u.edge_from_parent->traj)
+            errors++;
+    }
+    if(!num_rewired)
+        errors++;
+
+    // nothing is stored without cache_trajectories
+    si_rrts_t uncached;
+    uncached.cache_trajectories = false;
+    set_si_problem(uncached.system, 5);
+    uncached.initialize(si_system_t::state(s0));
+    for(int i=0; i<1000; i++)
+        uncached.iteration();
+    if(uncached.get_best_trajectory(buffer) || !is_same_trajectory(buffer, traj))
+        errors++;
+    for(auto& pv : uncached.list_vertices)
+    {
+        if(pv->edge_from_parent && pv->edge_from_parent->traj)
+            errors++;
+    }
+    cout<<"edge trajectories, rewired: "<< num_rewired <<" of "<< cached_parents.size()
+        <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// the dt of a dubins edge is the length of the path extend_to samples,
+// not its cost, which charges for tight turns
+int test_dubins_edge_duration()
+{
+    typedef system_c<dubins_c, map_c<3>, region_c<3>, cost_c<1> > system_t;
+    rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts;
+    double oc[3] = {0, 0, 0}, os[3] = {100, 100, 2*M_PI};
+    double gc[3] = {10, 10, M_PI/2}, gs[3] = {2, 2, 0.2*M_PI};
+    rrts.system.operating_region = region_c<3>(oc, os);
+    rrts.system.goal_region = region_c<3>(gc, gs);
+    rrts.system.rng.seed(1);
+    double s0[3] = {0, 0, 0};
+    rrts.initialize(system_t::state(s0));
+    for(int i=0; i<500; i++)
+        rrts.iteration();
+
+    int errors = 0;
+    int num_penalized = 0;
+    for(auto& pv : rrts.list_vertices)
+    {
+        if(!pv->parent)
+            continue;
+        auto& e = *(pv->edge_from_parent);
+        system_t::trajectory traj;
+        rrts.system.dynamical_system.extend_to(pv->parent->state, pv->state, traj, e.opt_data);
+        if((fabs(e.dt - traj.total_variation) > 1e-9) || (fabs(pv->t0 - pv->parent->t0 - e.dt) > 1e-9))
+            errors++;
+        num_penalized += (e.cost.val[0] > e.dt + 1e-9);
+    }
+    if(!num_penalized)
+        errors++;
+    cout<<"dubins, vertices: "<< rrts.num_vertices <<" errors: "<< errors << endl;
+    return errors;
+}
+
+// a system that charges twice the distance, the planners have to use the
+// cost of the 4-argument evaluate_extend_cost and the duration of the steer
+class double_cost_system_c : public si_system_t
+{
+    public:
+        int evaluate_extend_cost(const state& si, const state& sf,
+                opt_data_t& opt_data, cost_t& extend_cost)
+        {
+            if(si_system_t::evaluate_extend_cost(si, sf, opt_data, extend_cost))
+                return 1;
+            extend_cost.val[0] *= 2;
+            return 0;
+        }
+        using si_system_t::evaluate_extend_cost;
+};
+
+int test_evaluate_extend_cost_override()
+{
+    rrts_c<vertex_c<double_cost_system_c>, edge_c<double_cost_system_c> > rrts;
+    set_si_problem(rrts.system, 5);
+    double s0[2] = {0, 0};
+    rrts.initialize(double_cost_system_c::state(s0));
+    for(int i=0; i<500; i++)
+        rrts.iteration();
+
+    int errors = 0;
+    for(auto& pv : rrts.list_vertices)
+    {
+        if(!pv->parent)
+            continue;
+        double d = pv->parent->state.dist(pv->state);
+        if((fabs(pv->cost_from_parent.val[0] - 2*d) > 1e-9) || (fabs(pv->edge_from_parent->dt - d) > 1e-9))
+            errors++;
+    }
+    cout<<"evaluate_extend_cost override, cost: "<< rrts.get_best_cost().val[0] <<" errors: "<< errors << endl;
+    return errors;
+}
+
+int main()
+{
+    int errors = 0;
+    errors += test_informed_goal_region();
+    errors += test_parallel_rrts();
+    errors += test_birrts_check_tree();
+    errors += test_rrts_soa();
+    errors += test_bitstar();
+    errors += test_fmts();
+    errors += test_lazy();
+    errors += test_k_nearest();
+    errors += test_branch_costs();
+    errors += test_seeds();
+    errors += test_plan_for<rrts_c<vertex_c<si_box_system_t>, edge_c<si_box_system_t> > >("rrts_c");
+    errors += test_plan_for<brrts_c<bvertex_c<si_box_system_t>, bedge_c<si_box_system_t> > >("brrts_c");
+    errors += test_edge_trajectories();
+    errors += test_dubins_edge_duration();
+    errors += test_evaluate_extend_cost_override();
+    return errors ? 1 : 0;
+}
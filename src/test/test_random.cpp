@@ -0,0 +1,109 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "../random.h"
+using namespace std;
+
+/*
+ * Equal seeds have to give equal streams, forks have to be deterministic
+ * and not overlap or correlate with the stream they were forked from.
+ */
+vector<uint64_t> draw(random_c& rng, size_t n)
+{
+    vector<uint64_t> t(n);
+    for(auto& x : t)
+        x = rng.next();
+    return t;
+}
+
+int test_seed()
+{
+    int errors = 0;
+    random_c r1(7), r2(7), r3(8);
+    vector<uint64_t> t1 = draw(r1, 1000);
+    if(t1 != draw(r2, 1000))
+        errors++;
+    if(t1 == draw(r3, 1000))
+        errors++;
+
+    // seed restarts the stream
+    r1.seed(7);
+    if(t1 != draw(r1, 1000))
+        errors++;
+
+    // the first draws of seed 0, the same on every platform
+    random_c r0;
+    const uint64_t first[3] = {0x99ec5f36cb75f2b4ULL, 0xbf6e1f784956452aULL, 0x1a5f849d4933e6e0ULL};
+    for(int i=0; i<3; i++)
+    {
+        if(r0.next() != first[i])
+            errors++;
+    }
+    cout<<"seed, errors: "<< errors << endl;
+    return errors;
+}
+
+int test_fork()
+{
+    int errors = 0;
+    random_c r1(7), r2(7), r3(7);
+
+    // fork hands out the current stream and jumps this one
+    vector<uint64_t> t = draw(r3, 1000);
+    random_c f1 = r1.fork();
+    if(draw(f1, 1000) != t)
+        errors++;
+
+    // forking is deterministic
+    random_c f2 = r2.fork();
+    draw(f2, 1000);
+    vector<uint64_t> p1 = draw(r1, 10000), p2 = draw(r2, 10000);
+    if(p1 != p2)
+        errors++;
+    random_c g1 = r1.fork(), g2 = r2.fork();
+    vector<uint64_t> c1 = draw(g1, 10000);
+    if(c1 != draw(g2, 10000))
+        errors++;
+
+    // no draw of a fork shows up in its parent's stream or another fork's
+    vector<uint64_t> parent = draw(r1, 10000);
+    random_c h1 = r1.fork();
+    vector<uint64_t> c2 = draw(h1, 10000);
+    vector<uint64_t> all(parent);
+    all.insert(all.end(), c1.begin(), c1.end());
+    all.insert(all.end(), c2.begin(), c2.end());
+    sort(all.begin(), all.end());
+    if(unique(all.begin(), all.end()) != all.end())
+        errors++;
+
+    // uniforms of the parent and a fork drawn side by side
+    random_c a(7);
+    random_c b = a.fork();
+    size_t n = 100000;
+    double sa = 0, sb = 0, sab = 0, saa = 0, sbb = 0;
+    for(size_t i=0; i<n; i++)
+    {
+        double x = a.uniform(), y = b.uniform();
+        sa += x;
+        sb += y;
+        sab += x*y;
+        saa += x*x;
+        sbb += y*y;
+    }
+    double cov = sab/n - (sa/n)*(sb/n);
+    double corr = cov/sqrt((saa/n - (sa/n)*(sa/n))*(sbb/n - (sb/n)*(sb/n)));
+    if(fabs(corr) > 0.02)
+        errors++;
+    cout<<"fork, correlation: "<< corr <<" errors: "<< errors << endl;
+    return errors;
+}
+
+int main()
+{
+    int errors = 0;
+    errors += test_seed();
+    errors += test_fork();
+    return errors ? 1 : 0;
+}
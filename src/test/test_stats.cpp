@@ -0,0 +1,75 @@
+#include <iostream>
+#include <cmath>
+
+#include "../utils.h"
+#include "../single_integrator.h"
+#include "../box_map.h"
+#include "../rrts.h"
+using namespace std;
+
+/*
+ * Built with SMPL_STATS defined (see CMakeLists.txt), the counters of
+ * rrts_c have to follow the planning, and reset_stats has to clear them.
+ */
+#ifndef SMPL_STATS
+#error "test_stats needs SMPL_STATS"
+#endif
+
+typedef system_c<single_integrator_c<2>, box_map_c<2>, region_c<2>, cost_c<1> > system_t;
+typedef rrts_c<vertex_c<system_t>, edge_c<system_t> > rrts_t;
+
+int check_stats(rrts_t& rrts, size_t iterations)
+{
+    int errors = 0;
+    rrts_stats_t s = rrts.get_stats();
+    if((s.iterations != iterations) || !s.added_vertices || (s.added_vertices > s.iterations))
+        errors++;
+    if((s.samples < s.iterations) || !s.rejected_samples)
+        errors++;
+    if((s.near_queries != s.iterations) || !s.near_vertices || !s.max_near_vertices)
+        errors++;
+    if(!s.steering_evaluations || !s.collision_checks || !s.rewires)
+        errors++;
+    if(!s.cost_updates || !s.cost_updated_vertices || !s.max_cost_depth)
+        errors++;
+    if(!(s.sample_time > 0) || !(s.near_time > 0) || !(s.parent_time > 0) || !(s.rewire_time > 0)
+            || !(s.iteration_time >= s.sample_time + s.near_time + s.parent_time + s.rewire_time))
+        errors++;
+    return errors;
+}
+
+int main()
+{
+    int errors = 0;
+    for(int lazy=0; lazy<2; lazy++)
+    {
+        rrts_t rrts;
+        double oc[2] = {0, 0}, os[2] = {100, 100};
+        double gc[2] = {40, 40}, gs[2] = {5, 5};
+        double bc[2] = {20, 20}, bs[2] = {10, 10};
+        rrts.system.operating_region = region_c<2>(oc, os);
+        rrts.system.goal_region = region_c<2>(gc, gs);
+        rrts.system.obstacle_map.add_box(bc, bs);
+        rrts.system.rng.seed(1);
+        rrts.lazy_collision_checking = lazy;
+        double s0[2] = {0, 0};
+        rrts.initialize(system_t::state(s0));
+        for(int i=0; i<2000; i++)
+            rrts.iteration();
+        int e = check_stats(rrts, 2000);
+
+        rrts.reset_stats();
+        rrts_stats_t s = rrts.get_stats();
+        if(s.iterations || s.samples || s.collision_checks || (s.iteration_time != 0))
+            e++;
+        for(int i=0; i<100; i++)
+            rrts.iteration();
+        if(rrts.get_stats().iterations != 100)
+            e++;
+
+        cout<<(lazy ? "lazy" : "eager") <<", errors: "<< e << endl;
+        rrts.get_stats().print();
+        errors += e;
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+#ifndef __thread_pool_h__
+#define __thread_pool_h__
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+using namespace std;
+
+/*
+ * Fixed set of worker threads for data-parallel loops. parallel_for(n, f)
+ * calls f(i) for every i in [0, n) on the workers and the calling thread,
+ * and returns once all calls have finished. Indices are handed out one at a
+ * time, so the iterations can be of very different length.
+ */
+class thread_pool_c
+{
+    public:
+        // num_threads counts the calling thread, 0 uses all hardware threads
+        thread_pool_c(size_t num_threads=0)
+        {
+            if(!num_threads)
+                num_threads = thread::hardware_concurrency();
+            if(!num_threads)
+                num_threads = 1;
+
+            job = NULL;
+            job_size = 0;
+            next_index = 0;
+            num_busy = 0;
+            generation = 0;
+            stop = false;
+            for(size_t i=1; i<num_threads; i++)
+                workers.push_back(thread(&thread_pool_c::worker_loop, this));
+        }
+        ~thread_pool_c()
+        {
+            {
+                unique_lock<mutex> lock(job_mutex);
+                stop = true;
+            }
+            start_cv.notify_all();
+            for(auto& w : workers)
+                w.join();
+        }
+
+        size_t size() const
+        {
+            return workers.size() + 1;
+        }
+
+        void parallel_for(size_t n, const function<void(size_t)>& f)
+        {
+            if(!n)
+                return;
+            if(workers.empty() || (n == 1))
+            {
+                for(size_t i=0; i<n; i++)
+                    f(i);
+                return;
+            }
+
+            {
+                unique_lock<mutex> lock(job_mutex);
+                job = &f;
+                job_size = n;
+                next_index = 0;
+                num_busy = workers.size();
+                generation++;
+            }
+            start_cv.notify_all();
+
+            run_job(f, n);
+
+            unique_lock<mutex> lock(job_mutex);
+            done_cv.wait(lock, [this]{ return num_busy == 0; });
+            job = NULL;
+        }
+
+    private:
+        vector<thread> workers;
+        mutex job_mutex;
+        condition_variable start_cv;
+        condition_variable done_cv;
+
+        const function<void(size_t)>* job;
+        size_t job_size;
+        atomic<size_t> next_index;
+        size_t num_busy;
+        size_t generation;
+        bool stop;
+
+        void run_job(const function<void(size_t)>& f, size_t n)
+        {
+            size_t i;
+            while((i = next_index.fetch_add(1)) < n)
+                f(i);
+        }
+
+        void worker_loop()
+        {
+            size_t last_generation = 0;
+            unique_lock<mutex> lock(job_mutex);
+            while(true)
+            {
+                start_cv.wait(lock, [&]{ return stop || (generation != last_generation); });
+                if(stop)
+                    return;
+                last_generation = generation;
+                const function<void(size_t)>& f = *job;
+                size_t n = job_size;
+
+                lock.unlock();
+                run_job(f, n);
+                lock.lock();
+
+                if(--num_busy == 0)
+                    done_cv.notify_one();
+            }
+        }
+
+        thread_pool_c(const thread_pool_c&);
+        thread_pool_c& operator=(const thread_pool_c&);
+};
+
+#endif